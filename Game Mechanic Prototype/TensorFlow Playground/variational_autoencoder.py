@@ -3,11 +3,30 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import glob
+import json
+import os
+import struct
+import numpy as np
 import tensorflow as tf
 import weapon_data
 
 DEFAULT_MODEL_PATH = "trained_vae/"
 
+#binary model file read by the native weapon generator (see 'Source/ThesisPrototype/Weapons/WeaponGeneratorVAE.h')
+#header: magic, version, transfer function, n_input, n_hidden_1, n_hidden_2, n_z, batch_size, followed by the tensor table
+MODEL_FILE_MAGIC = b'WVAE'
+MODEL_FILE_VERSION = 1
+MODEL_FILE_HEADER_FORMAT = '<4sIIiiiii'
+#(offset in bytes, number of floats) per tensor
+MODEL_FILE_TENSOR_ENTRY_FORMAT = '<II'
+MODEL_FILE_TENSOR_ALIGNMENT = 64
+MODEL_FILE_TRANSFER_FUNCTIONS = ['tanh', 'elu', 'relu', 'softplus', 'sigmoid']
+#tensors are written in this order, matrices are row-major with the shape [inputs, outputs]
+MODEL_FILE_TENSORS = ['mean', 'std',
+                      'encoder_h1', 'encoder_h2', 'encoder_z_mean', 'encoder_z_ls2',
+                      'decoder_h1', 'decoder_h2', 'decoder_out']
+
 def get_untrained(session, network_architecture, optimizer, transfer_fct, batch_size=1):
     '''Convenience wrapper to get an untrained Variational Autoencoder
 
@@ -263,6 +282,37 @@ class VariationalAutoencoder(object):
             samples = [x[0] for _ in range(self._batch_size)]
             return self._session.run(self.x_reconstructed_mean, feed_dict={self.X: samples})
 
+    def encode_and_decode_batch(self, x, samples_per_input=None):
+        """Reconstructs every row of x in one session run.
+            Like 'encode_and_decode(x, False)' for each row but without a session run per row.
+
+        Args:
+            x: Batch of any size - the shape need to match with the input data.
+            samples_per_input (int, optional): How many samples of the latent space are decoded and
+                averaged per row. Defaults to the batch size used during training like 'encode_and_decode'.
+
+        Returns:
+            [float]: One reconstruction per row of x.
+        """
+        if samples_per_input is None:
+            samples_per_input = self._batch_size
+        x = np.asarray(x)
+        samples = np.repeat(x, samples_per_input, axis=0)
+        reconstructed = self._session.run(self.x_reconstructed, feed_dict={self.X: samples})
+        return reconstructed.reshape((x.shape[0], samples_per_input, -1)).mean(axis=1)
+
+    def decode_batch(self, z):
+        """Decodes every row of z in one session run.
+            Like 'decode_from_latent_space(z, False)' for each row but without a session run per row.
+
+        Args:
+            z: Batch of any size - the shape need to match with the latent space dimension.
+
+        Returns:
+            [float]: One reconstruction per row of z.
+        """
+        return self._session.run(self.x_reconstructed, feed_dict={self.z: z})
+
     def load_trained_model(self, save_path):
         """Loads trained model from disk.
         CAUTION: Needs an open session with 'tf.Session(graph=tf.Graph())'!
@@ -287,6 +337,142 @@ class VariationalAutoencoder(object):
         self.__print("Model saved in file: {}".format(save_path))
         return save_path
 
+    def export_weights(self, path, data_set, binary=True):
+        """Exports all trained weights and biases together with the standardization of the data set
+            so that the native weapon generator in the engine can run the VAE without TensorFlow.
+            (see 'Source/ThesisPrototype/Weapons/WeaponGeneratorVAE.h')
+
+        Args:
+            path (str): Path to where the exported model will be saved in.
+            data_set (weapon_data.DataSet): The data set the model was trained with. Its mean and
+                standard deviation are needed to standardize the inputs and unstandardize the outputs.
+            binary (bool, optional): Writes the binary 'model.wvae' which the engine memory maps as is.
+                Otherwise a human readable 'model.json' is written.
+
+        Returns:
+            str: The full path of the exported model file.
+        """
+        weights_and_biases = self._session.run(self._weights_and_biases)
+        mean, std = data_set.standardization
+
+        layers = {}
+        for network in ['encoder', 'decoder']:
+            weights = weights_and_biases['weights_' + network]
+            biases = weights_and_biases['biases_' + network]
+            for layer in weights:
+                layers[network + '_' + layer] = (weights[layer], biases[layer])
+
+        if binary:
+            save_path = path + "model.wvae"
+            self.__write_binary_model(save_path + ".tmp", layers, data_set.feature_names, mean, std)
+            save_path = self.__replace_model_file(save_path + ".tmp", save_path)
+        else:
+            export = {
+                'version': 1,
+                'transfer_fct': self._transfer_fct.__name__,
+                'batch_size': self._batch_size,
+                'n_input': self._network_architecture['n_input'],
+                'n_hidden_1': self._network_architecture['n_hidden_1'],
+                'n_hidden_2': self._network_architecture['n_hidden_2'] if self._has_2_hidden_layer else 0,
+                'n_z': self._network_architecture['n_z'],
+                'columns': data_set.feature_names,
+                'mean': mean.tolist(),
+                'std': std.tolist(),
+                'layers': {}
+            }
+
+            #matrices are flattened row-major with the shape [inputs, outputs]
+            for name, (weights, biases) in layers.items():
+                export['layers'][name] = {
+                    'shape': list(weights.shape),
+                    'weights': weights.flatten().tolist(),
+                    'biases': biases.flatten().tolist()
+                }
+
+            save_path = path + "model.json"
+            with open(save_path + ".tmp", mode='w') as file:
+                json.dump(export, file)
+            save_path = self.__replace_model_file(save_path + ".tmp", save_path)
+
+        self.__print("Model weights exported to file: {}".format(save_path))
+        return save_path
+
+    def __write_binary_model(self, save_path, layers, columns, mean, std):
+        #the engine expects the features in the order of weapon_data.ENCODED_FEATURE_NAMES
+        #and not sorted by name like the TensorFlow feature columns
+        order = [columns.index(name) for name in weapon_data.ENCODED_FEATURE_NAMES]
+        std = np.where(std > 0, std, 1)
+
+        tensors = {'mean': np.asarray(mean)[order], 'std': np.asarray(std)[order]}
+        for name, (weights, biases) in layers.items():
+            if name == 'encoder_h1':
+                weights = weights[order, :]
+            elif name == 'decoder_out':
+                weights = weights[:, order]
+                biases = biases[order]
+            tensors[name + '_weights'] = weights
+            tensors[name + '_biases'] = biases
+
+        tensor_list = []
+        for name in MODEL_FILE_TENSORS:
+            if name in ['mean', 'std']:
+                tensor_list.append(tensors[name])
+            else:
+                #an unused second hidden layer is written as empty tensors
+                empty = np.zeros(0)
+                tensor_list.append(tensors.get(name + '_weights', empty))
+                tensor_list.append(tensors.get(name + '_biases', empty))
+        tensor_list = [np.ascontiguousarray(t, dtype='<f4').flatten() for t in tensor_list]
+
+        def align(offset):
+            return (offset + MODEL_FILE_TENSOR_ALIGNMENT - 1) // MODEL_FILE_TENSOR_ALIGNMENT * MODEL_FILE_TENSOR_ALIGNMENT
+
+        offset = align(struct.calcsize(MODEL_FILE_HEADER_FORMAT) + len(tensor_list) * struct.calcsize(MODEL_FILE_TENSOR_ENTRY_FORMAT))
+        table = []
+        for tensor in tensor_list:
+            table.append((offset, tensor.size))
+            offset = align(offset + tensor.nbytes)
+
+        header = struct.pack(MODEL_FILE_HEADER_FORMAT, MODEL_FILE_MAGIC, MODEL_FILE_VERSION,
+                             MODEL_FILE_TRANSFER_FUNCTIONS.index(self._transfer_fct.__name__),
+                             self._network_architecture['n_input'],
+                             self._network_architecture['n_hidden_1'],
+                             self._network_architecture['n_hidden_2'] if self._has_2_hidden_layer else 0,
+                             self._network_architecture['n_z'],
+                             self._batch_size)
+        for entry in table:
+            header += struct.pack(MODEL_FILE_TENSOR_ENTRY_FORMAT, *entry)
+
+        with open(save_path, mode='wb') as file:
+            file.write(header)
+            for (tensor_offset, _), tensor in zip(table, tensor_list):
+                file.write(b'\0' * (tensor_offset - file.tell()))
+                file.write(tensor.tobytes())
+
+    def __replace_model_file(self, temp_path, save_path):
+        #the engine memory maps the model, so it must never be rewritten in place. a replaced file keeps
+        #the old mapping valid until the engine maps the new one with AWeaponGenerator.loadNativeModel
+        base_path, extension = os.path.splitext(save_path)
+        try:
+            os.replace(temp_path, save_path)
+        except OSError:
+            #windows doesn't replace a file which is still mapped, so the model gets a new version (e.g. 'model.1.wvae')
+            #instead. the engine always loads the newest version
+            version = 1
+            while os.path.exists("{}.{}{}".format(base_path, version, extension)):
+                version += 1
+            save_path = "{}.{}{}".format(base_path, version, extension)
+            os.replace(temp_path, save_path)
+
+        #remove the older versions which aren't mapped anymore
+        for old_path in glob.glob("{}.*{}".format(base_path, extension)):
+            if os.path.abspath(old_path) != os.path.abspath(save_path):
+                try:
+                    os.remove(old_path)
+                except OSError:
+                    pass
+        return save_path
+
 
     def calculate_z(self, X):
         """Calculates the sampled latent space z for a given dataset X.
@@ -348,6 +534,8 @@ class VariationalAutoencoder(object):
 
         #init all weights and biases used in the network
         weights_and_biases = self.__init_weights_and_biases()
+        #keep them so the trained values can be exported
+        self._weights_and_biases = weights_and_biases
 
         #create the encoder network which generates the latent network
         self.z_mean, self.z_log_sigma_sq = \
@@ -407,7 +595,8 @@ class VariationalAutoencoder(object):
         n_z = self._network_architecture['n_z']
 
         #sample a random epsilon from a gaussian normal distribution to approximate the gaussian
-        epsilon = tf.random_normal((self._batch_size, n_z), 0, 1, dtype=tf.float32)
+        #it is sized to the fed batch and not to the trained batch size, so batches of any size can be encoded
+        epsilon = tf.random_normal(tf.shape(self.z_mean), 0, 1, dtype=tf.float32)
 
         # sample z from a normal (gaussian) distribution -> z = mu + sigma*epsilon
         z = self.z_mean + tf.multiply(tf.sqrt(tf.exp(self.z_log_sigma_sq)), epsilon)
@@ -23,6 +23,8 @@ WEAPON_TYPES = ['Shotgun', 'Pistol', 'Rifle', 'SMG', 'Sniper', 'MG']
 WEAPON_FIREMODES = ['Automatic', 'Semi', 'Single']
 #create dict so we can iterate them
 CATEGORICAL_PARAMS_DEFINES_DICT = {'type':WEAPON_TYPES, 'firemode':WEAPON_FIREMODES}
+#order of the features in the native weapon generator of the engine (see 'Source/ThesisPrototype/Weapons/WeaponFeatureVector.h')
+ENCODED_FEATURE_NAMES = NUMERICAL_PARAMS + ['type_' + t for t in WEAPON_TYPES] + ['firemode_' + f for f in WEAPON_FIREMODES]
 
 
 def get_data(training_data_source=DEFAULT_TRAINING_DATA, test_data_source=DEFAULT_TEST_DATA, seed=19071991, debug=False):
@@ -98,6 +100,24 @@ class DataSet:
         '''Returns the number of examples found in the provided .csv data.'''
         return self._num_examples
 
+    @property
+    def feature_names(self):
+        '''Returns the names of all encoded features in the order of the encoded data, e.g., 'rof' or 'type_Pistol'.'''
+        names = []
+        for key in self._feature_cols_to_vars_dict:
+            if key[0] in self._numerical_params:
+                names.append(key[0])
+            elif (len(key[0]) > 0) and key[0][0] in self._categorical_params:
+                names += [key[0][0] + "_" + category for category in key[0][1]]
+        return names
+
+    @property
+    def standardization(self):
+        '''Returns the mean and standard deviation which are used to standardize the original data.'''
+        std = self._data_original.std(dtype=np.float64, axis=0)
+        mean = self._data_original.mean(dtype=np.float64, axis=0)
+        return mean, std
+
     @property
     def standardized_max_values(self):
         '''Returns the highest found values in the standardized data.'''
@@ -138,6 +138,8 @@ class WeaponGeneratorAPI(TFPluginAPI):
                     break;
             ue.log("Training Finised!")
             self._trained_model_path = network.save_trained_model(self.trained_model_save_folder)
+            #the native weapon generator of the engine reloads this file instead of running a session
+            network.export_weights(self.trained_model_save_folder, self._train_data)
             self._trained_model_available = True
             self._is_training = False
         return {}
@@ -175,14 +177,8 @@ class WeaponGeneratorAPI(TFPluginAPI):
                 self._is_training = True
 
     def __generate_random_weapons(self, num):
-        generated_weapons = []
-
-        for _ in range(num):
-            random_val = np.random.normal(size=(1, self._network_architecture["n_z"]))
-            weapons = self._vae.decode_from_latent_space(random_val, False)
-            [generated_weapons.append(weapon) for weapon in weapons]
-
-        return generated_weapons
+        random_val = np.random.normal(size=(num, self._network_architecture["n_z"]))
+        return list(self._vae.decode_batch(random_val))
 
 #NOTE: this is a module function, not a class function. Change your CLASSNAME to reflect your class
 #required function to get our api
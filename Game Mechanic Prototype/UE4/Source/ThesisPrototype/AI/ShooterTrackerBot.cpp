@@ -2,8 +2,6 @@
 
 #include "ShooterTrackerBot.h"
 #include "Components/StaticMeshComponent.h"
-#include "NavigationSystem.h"
-#include "NavigationPath.h"
 #include "Kismet/GameplayStatics.h"
 #include "GameFramework/Character.h"
 #include "Components/HealthComponent.h"
@@ -16,8 +14,9 @@
 #include "TimerManager.h"
 #include "Sound/SoundCue.h"
 #include "Components/AudioComponent.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "ChangingGuns.h"
+#include "TrackerBotManager.h"
+#include "ShooterEffectPool.h"
 
 static int32 DebugTrackerBotDrawing = 0;
 FAutoConsoleVariableRef CVARDebugTackerBotDrawing(
@@ -30,8 +29,8 @@ FAutoConsoleVariableRef CVARDebugTackerBotDrawing(
 // Sets default values
 AShooterTrackerBot::AShooterTrackerBot()
 {
- 	// Set this pawn to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	//the ATrackerBotManager moves all bots together
+	PrimaryActorTick.bCanEverTick = false;
 
 	meshComp = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("MeshComp"));
 	meshComp->SetCanEverAffectNavigation(false);
@@ -66,11 +65,16 @@ void AShooterTrackerBot::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// find initial move to
-	nextPathPoint = getNextPathPoint();
+	//the path is requested from the bot manager
+	botManager = ATrackerBotManager::Get(GetWorld());
+	if (botManager.IsValid())
+	{
+		botManager->RegisterBot(this);
+	}
 
-	FTimerHandle timerHandle_CheckPowerLevel;
-	GetWorldTimerManager().SetTimer(timerHandle_CheckPowerLevel, this, &AShooterTrackerBot::onCheckNearbyBots, 1.f, true);
+	// find initial move to
+	nextPathPoint = GetActorLocation();
+	requestNextPathPoint();
 
 	if (!materialInstance)
 	{
@@ -80,47 +84,87 @@ void AShooterTrackerBot::BeginPlay()
 	healthComp->OnHealthChangedEvent.AddDynamic(this, &AShooterTrackerBot::onHealthChanged);
 }
 
-FVector AShooterTrackerBot::getNextPathPoint()
+void AShooterTrackerBot::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	//hack to get player location
-	AActor* bestTarget = nullptr;
-	float nearestTargetDistance = FLT_MAX;
+	if (botManager.IsValid())
+	{
+		botManager->UnregisterBot(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AShooterTrackerBot::requestNextPathPoint()
+{
+	if (!botManager.IsValid())
+		return;
 
-	for (FConstPawnIterator it = GetWorld()->GetPawnIterator(); it; ++it)
+	//the bot manager selects the targets of all bots at once, new bots ask it directly
+	AActor* bestTarget = nearestTarget.Get();
+	if (!bestTarget)
 	{
-		APawn* testPawn = it->Get();
-		if (!testPawn || UHealthComponent::IsFriendly(this, testPawn))
-		{
-			continue;
-		}
-		UHealthComponent* healthComp = Cast<UHealthComponent>(testPawn->GetComponentByClass(UHealthComponent::StaticClass()));
-		if (healthComp && healthComp->GetHealth() > 0.f)
-		{
-			const float distanceToPawn = FVector::Distance(this->GetActorLocation(), testPawn->GetActorLocation());
-			if(distanceToPawn < nearestTargetDistance)
-			{
-				bestTarget = testPawn;
-				nearestTargetDistance = distanceToPawn;
-			}
-		}
+		bestTarget = botManager->FindNearestTarget(GetActorLocation());
 	}
 
 	if(bestTarget)
 	{
-		UNavigationPath* navPath = UNavigationSystemV1::FindPathToActorSynchronously(this, GetActorLocation(), bestTarget);
+		//the bot manager moves the bot along the flow field of the target instead
+		FVector flowFieldPathPoint;
+		if (botManager->SampleFlowField(bestTarget, GetActorLocation(), flowFieldPathPoint))
+		{
+			FollowFlowField(flowFieldPathPoint);
+			return;
+		}
 
 		GetWorldTimerManager().ClearTimer(timerHandle_refreshPath);
 		GetWorldTimerManager().SetTimer(timerHandle_refreshPath, this, &AShooterTrackerBot::refreshPath, 2.5f, false);
 
-		if (navPath && navPath->PathPoints.Num() > 1)
+		//keep moving to the current path point until the path has been found
+		bIsWaitingForPath = true;
+		botManager->RequestPath(this, bestTarget);
+		return;
+	}
+
+	//Failed to find target
+	nextPathPoint = GetActorLocation();
+}
+
+void AShooterTrackerBot::FollowFlowField(const FVector& PathPoint)
+{
+	nextPathPoint = PathPoint;
+	if (!bIsFollowingFlowField)
+	{
+		bIsFollowingFlowField = true;
+		GetWorldTimerManager().ClearTimer(timerHandle_refreshPath);
+	}
+}
+
+void AShooterTrackerBot::OnFlowFieldLeft()
+{
+	bIsFollowingFlowField = false;
+	requestNextPathPoint();
+}
+
+void AShooterTrackerBot::OnPathFound(const TArray<FVector>& PathPoints)
+{
+	bIsWaitingForPath = false;
+
+	//requested before the bot entered the flow field
+	if (bIsFollowingFlowField)
+		return;
+
+	//the path might be shared with a bot which started nearby, so skip the points which are already reached
+	for (int32 i = 1; i < PathPoints.Num(); ++i)
+	{
+		if ((PathPoints[i] - GetActorLocation()).Size() > requiredDistanceToTarget || i == PathPoints.Num() - 1)
 		{
-			//return next point in the path
-			return navPath->PathPoints[1];
+			nextPathPoint = PathPoints[i];
+			return;
 		}
 	}
 
 	//Failed to find path
-	return GetActorLocation();
+	nextPathPoint = GetActorLocation();
 }
 
 void AShooterTrackerBot::onHealthChanged(const UHealthComponent* HealthComponent, float Health, float HealthDelta, const UDamageType* healthDamageType, AController* InstigatedBy, AActor* DamageCauser)
@@ -143,18 +187,33 @@ void AShooterTrackerBot::selfDestruct()
 	}
 
 	bExploded = true;
-	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), explosionEffect, GetActorLocation());
-	UGameplayStatics::PlaySoundAtLocation(this, explosionSound, GetActorLocation());
+	if (AShooterEffectPool* effectPool = AShooterEffectPool::Get(GetWorld()))
+	{
+		effectPool->SpawnEmitterAtLocation(explosionEffect, GetActorLocation());
+		effectPool->PlaySoundAtLocation(explosionSound, GetActorLocation());
+	}
 
 	meshComp->SetVisibility(false, true);
 	meshComp->SetSimulatePhysics(false);
 	meshComp->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
+	//exploded bots don't move anymore
+	UpdateMovementVolume(0.1f, 0.f);
+
+	//exploded bots don't boost the others anymore
+	if (botManager.IsValid())
+	{
+		botManager->UnregisterBot(this);
+	}
+
 	TArray<AActor*> ignoreDamageActors{ this };
 
 	const float actualDamage = explosionDamage + (explosionDamage * currentPowerLevel);
 
-	UGameplayStatics::ApplyRadialDamage(GetWorld(), actualDamage, GetActorLocation(), damageRadius, damageType, ignoreDamageActors, this, GetInstigatorController(), true);
+	{
+		FScopedGameFrameTiming timing(EGameFrameTiming::Overlaps);
+		UGameplayStatics::ApplyRadialDamage(GetWorld(), actualDamage, GetActorLocation(), damageRadius, damageType, ignoreDamageActors, this, GetInstigatorController(), true);
+	}
 
 	if (DebugTrackerBotDrawing > 0)
 	{
@@ -169,36 +228,19 @@ void AShooterTrackerBot::damageSelf()
 	UGameplayStatics::ApplyDamage(this, 20, GetInstigatorController(), this, nullptr);
 }
 
-void AShooterTrackerBot::onCheckNearbyBots()
+void AShooterTrackerBot::UpdatePowerLevel(int32 NumOfNearbyBots, float NearbyRadius)
 {
-	const float checkRadius = 600;
-
 	if (DebugTrackerBotDrawing > 0)
 	{
-		DrawDebugSphere(GetWorld(), GetActorLocation(), checkRadius, 12, FColor::White, false, 1.f);
+		DrawDebugSphere(GetWorld(), GetActorLocation(), NearbyRadius, 12, FColor::White, false, 0.f);
 	}
 
-	int32 numOfNearbyBots = 0;
-
-	FCollisionShape collShape;
-	collShape.SetSphere(checkRadius);
-
-	FCollisionObjectQueryParams queryParams;
-	queryParams.AddObjectTypesToQuery(ECC_PhysicsBody);
-	queryParams.AddObjectTypesToQuery(ECC_Pawn);
-
-	TArray<FOverlapResult> overlaps;
-	GetWorld()->OverlapMultiByObjectType(overlaps, GetActorLocation(), FQuat::Identity, queryParams, collShape);
-	for(const FOverlapResult& overlap : overlaps)
+	const int32 powerLevel = FMath::Clamp(NumOfNearbyBots, 0, maxPowerLevel);
+	if (powerLevel == currentPowerLevel)
 	{
-		AShooterTrackerBot* bot = Cast<AShooterTrackerBot>(overlap.GetActor());
-		if(bot && bot != this)
-		{
-			++numOfNearbyBots;
-		}
+		return;
 	}
-
-	currentPowerLevel = FMath::Clamp(numOfNearbyBots, 0, maxPowerLevel);
+	currentPowerLevel = powerLevel;
 
 	if (materialInstance)
 	{
@@ -214,46 +256,47 @@ void AShooterTrackerBot::onCheckNearbyBots()
 
 void AShooterTrackerBot::refreshPath()
 {
-	nextPathPoint = getNextPathPoint();
+	requestNextPathPoint();
 }
 
-// Called every frame
-void AShooterTrackerBot::Tick(float DeltaTime)
+void AShooterTrackerBot::AddMovementForce(const FVector& Force, float Duration)
 {
-	Super::Tick(DeltaTime);
-
-	if(!bExploded)
+	if (Duration > 0.f)
 	{
-		float distanceToTarget = (GetActorLocation() - nextPathPoint).Size();
-		if (distanceToTarget <= requiredDistanceToTarget)
-		{
-			nextPathPoint = getNextPathPoint();
-		}
-		else
-		{
-			//keep moving towards target
-			FVector forceDirection = nextPathPoint - GetActorLocation();
-			forceDirection.Normalize();
-			forceDirection *= movementForce;
+		meshComp->AddImpulse(Force * Duration, NAME_None, bUseVelocityChange);
+	}
+	else
+	{
+		meshComp->AddForce(Force, NAME_None, bUseVelocityChange);
+	}
 
-			meshComp->AddForce(forceDirection, NAME_None, bUseVelocityChange);
+	if (DebugTrackerBotDrawing > 0)
+	{
+		DrawDebugDirectionalArrow(GetWorld(), GetActorLocation(), GetActorLocation() + Force, 32, FColor::Green, false, 0.f, 0, 1.f);
+		DrawDebugSphere(GetWorld(), nextPathPoint, 20, 12, FColor::Green, false, 0.f, 1.f);
+	}
+}
 
-			if (DebugTrackerBotDrawing > 0)
-			{
-				DrawDebugDirectionalArrow(GetWorld(), GetActorLocation(), GetActorLocation() + forceDirection, 32, FColor::Green, false, 0.f, 0, 1.f);
-			}
-		}
+void AShooterTrackerBot::OnPathPointReached()
+{
+	if (!bIsWaitingForPath)
+	{
+		requestNextPathPoint();
+	}
 
-		if (DebugTrackerBotDrawing > 0)
-		{
-			DrawDebugSphere(GetWorld(), nextPathPoint, 20, 12, FColor::Green, false, 0.f, 1.f);
-		}
+	if (DebugTrackerBotDrawing > 0)
+	{
+		DrawDebugSphere(GetWorld(), nextPathPoint, 20, 12, FColor::Green, false, 0.f, 1.f);
 	}
+}
 
-	// movement sound
-	float velocity = GetVelocity().Size();
-	float volumeMultiplier = UKismetMathLibrary::MapRangeClamped(velocity, 10, 1000, 0.1, 2);
-	movementAudioComponent->SetVolumeMultiplier(volumeMultiplier);
+void AShooterTrackerBot::UpdateMovementVolume(float VolumeMultiplier, float Threshold)
+{
+	if (FMath::Abs(VolumeMultiplier - movementVolumeMultiplier) < Threshold)
+		return;
+
+	movementVolumeMultiplier = VolumeMultiplier;
+	movementAudioComponent->SetVolumeMultiplier(VolumeMultiplier);
 }
 
 void AShooterTrackerBot::NotifyActorBeginOverlap(AActor* OtherActor)
@@ -270,7 +313,10 @@ void AShooterTrackerBot::NotifyActorBeginOverlap(AActor* OtherActor)
 
 			bStartedSelfDestruction = true;
 
-			UGameplayStatics::SpawnSoundAttached(selfDestructSound, RootComponent);
+			if (AShooterEffectPool* effectPool = AShooterEffectPool::Get(GetWorld()))
+			{
+				effectPool->SpawnSoundAttached(selfDestructSound, RootComponent);
+			}
 		}
 	}
 }
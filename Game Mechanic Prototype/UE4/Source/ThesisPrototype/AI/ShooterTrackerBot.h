@@ -10,6 +10,7 @@ class UHealthComponent;
 class USphereComponent;
 class USoundCue;
 class UAudioComponent;
+class ATrackerBotManager;
 
 UCLASS()
 class THESISPROTOTYPE_API AShooterTrackerBot : public APawn
@@ -69,16 +70,40 @@ protected:
 public:
 	// Sets default values for this pawn's properties
 	AShooterTrackerBot();
-	void Tick(float DeltaTime) override;
 	void NotifyActorBeginOverlap(AActor* OtherActor) override;
 
+	//called by the ATrackerBotManager with the number of other bots within NearbyRadius
+	void UpdatePowerLevel(int32 NumOfNearbyBots, float NearbyRadius);
+
+	//called by the ATrackerBotManager every frame
+	FORCEINLINE void SetNearestTarget(AActor* Target) { nearestTarget = Target; }
+
+	//called by the ATrackerBotManager when the requested path has been found, PathPoints is empty if there is none
+	void OnPathFound(const TArray<FVector>& PathPoints);
+
+	//the bots don't tick, the ATrackerBotManager moves all of them together
+	FORCEINLINE const FVector& GetNextPathPoint() const { return nextPathPoint; }
+	//called by the ATrackerBotManager while the flow field of the target covers the bot, meanwhile the bot doesn't request paths
+	void FollowFlowField(const FVector& PathPoint);
+	//called by the ATrackerBotManager once the flow field doesn't cover the bot anymore
+	void OnFlowFieldLeft();
+	FORCEINLINE bool IsFollowingFlowField() const { return bIsFollowingFlowField; }
+	FORCEINLINE float GetMovementForce() const { return movementForce; }
+	FORCEINLINE float GetRequiredDistanceToTarget() const { return requiredDistanceToTarget; }
+	//Duration > 0 applies the force of the frames which have been skipped by the tick LOD at once
+	void AddMovementForce(const FVector& Force, float Duration = 0.f);
+	void OnPathPointReached();
+	//the volume is only changed if it differs by at least Threshold from the current one
+	void UpdateMovementVolume(float VolumeMultiplier, float Threshold);
+
 protected:
 	void BeginPlay() override;
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	FVector getNextPathPoint();
+	//requests a path to the nearest target from the bot manager, see OnPathFound
+	void requestNextPathPoint();
 	void selfDestruct();
 	void damageSelf();
-	void onCheckNearbyBots();
 	void refreshPath();
 
 	UFUNCTION()
@@ -90,7 +115,13 @@ protected:
 	FTimerHandle timerHandle_selfDamage;
 	FTimerHandle timerHandle_refreshPath;
 	bool bStartedSelfDestruction = false;
+	bool bIsWaitingForPath = false;
+	bool bIsFollowingFlowField = false;
+	float movementVolumeMultiplier = 1.f;
 
 	//current power level of the bot based on nearby located bots -> this boosts the explosion damage
 	int32 currentPowerLevel = 0;
+
+	TWeakObjectPtr<AActor> nearestTarget;
+	TWeakObjectPtr<ATrackerBotManager> botManager;
 };
@@ -0,0 +1,151 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "TrackerBotFlowField.h"
+#include "NavigationSystem.h"
+#include "NavigationData.h"
+
+const float FTrackerBotFlowField::CellSize = 100.f;
+const float FTrackerBotFlowField::HeightBandSize = 400.f;
+
+bool FTrackerBotFlowField::Update(UNavigationSystemV1& NavigationSystem, const ANavigationData& NavigationData, const FVector& TargetLocation, TMap<FIntVector, bool>& NavigableCells, int32& NavigationSampleBudget)
+{
+	const FIntPoint newTargetCell = GetCell(TargetLocation);
+	const int32 newTargetHeightBand = GetHeightBand(TargetLocation.Z);
+	if (newTargetCell != targetCell || newTargetHeightBand != targetHeightBand)
+	{
+		//the old field stays valid until the new one is built
+		targetCell = newTargetCell;
+		originCell = targetCell - FIntPoint(GridSize / 2, GridSize / 2);
+		targetHeightBand = newTargetHeightBand;
+		bNeedsRebuild = true;
+	}
+
+	if (!bNeedsRebuild)
+		return true;
+
+	//only cells which haven't been part of any field in this height band yet are projected, from the center of the band
+	const FVector projectionExtent(CellSize * 0.5f, CellSize * 0.5f, HeightBandSize);
+	for (int32 y = 0; y < GridSize; ++y)
+	{
+		for (int32 x = 0; x < GridSize; ++x)
+		{
+			const FIntVector cell(originCell.X + x, originCell.Y + y, targetHeightBand);
+			if (NavigableCells.Contains(cell))
+				continue;
+
+			if (NavigationSampleBudget <= 0)
+				return false;
+			--NavigationSampleBudget;
+
+			const FVector cellCenter((cell.X + 0.5f) * CellSize, (cell.Y + 0.5f) * CellSize, (cell.Z + 0.5f) * HeightBandSize);
+			FNavLocation navLocation;
+			NavigableCells.Add(cell, NavigationSystem.ProjectPointToNavigation(cellCenter, navLocation, projectionExtent, &NavigationData));
+		}
+	}
+
+	integrate(NavigableCells);
+	return true;
+}
+
+void FTrackerBotFlowField::integrate(const TMap<FIntVector, bool>& NavigableCells)
+{
+	const int32 numCells = GridSize * GridSize;
+	TArray<bool> isNavigable;
+	isNavigable.SetNumUninitialized(numCells);
+	for (int32 i = 0; i < numCells; ++i)
+	{
+		const bool* navigable = NavigableCells.Find(FIntVector(originCell.X + i % GridSize, originCell.Y + i / GridSize, targetHeightBand));
+		isNavigable[i] = navigable && *navigable;
+	}
+
+	//breadth first search from the target cell, the target itself is always reachable
+	integrationField.Init(MAX_int32, numCells);
+	const FIntPoint targetGridCell = targetCell - originCell;
+	TArray<int32> openCells;
+	openCells.Reserve(numCells);
+	openCells.Add(getIndex(targetGridCell));
+	integrationField[openCells[0]] = 0;
+
+	const FIntPoint orthogonalNeighbours[] = { FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1) };
+	for (int32 next = 0; next < openCells.Num(); ++next)
+	{
+		const int32 index = openCells[next];
+		const FIntPoint gridCell(index % GridSize, index / GridSize);
+		for (const FIntPoint& offset : orthogonalNeighbours)
+		{
+			const FIntPoint neighbour = gridCell + offset;
+			if (!isInGrid(neighbour))
+				continue;
+
+			const int32 neighbourIndex = getIndex(neighbour);
+			if (isNavigable[neighbourIndex] && integrationField[neighbourIndex] == MAX_int32)
+			{
+				integrationField[neighbourIndex] = integrationField[index] + 1;
+				openCells.Add(neighbourIndex);
+			}
+		}
+	}
+
+	//every cell points to its cheapest neighbour, diagonals only if they don't cut a corner
+	directionField.Init(FVector2D::ZeroVector, numCells);
+	for (int32 index = 0; index < numCells; ++index)
+	{
+		if (integrationField[index] == MAX_int32 || integrationField[index] == 0)
+			continue;
+
+		const FIntPoint gridCell(index % GridSize, index / GridSize);
+		int32 lowestCost = integrationField[index];
+		for (int32 y = -1; y <= 1; ++y)
+		{
+			for (int32 x = -1; x <= 1; ++x)
+			{
+				const FIntPoint neighbour = gridCell + FIntPoint(x, y);
+				if ((x == 0 && y == 0) || !isInGrid(neighbour))
+					continue;
+
+				if (x != 0 && y != 0 && (integrationField[getIndex(gridCell + FIntPoint(x, 0))] == MAX_int32 || integrationField[getIndex(gridCell + FIntPoint(0, y))] == MAX_int32))
+					continue;
+
+				const int32 cost = integrationField[getIndex(neighbour)];
+				if (cost < lowestCost)
+				{
+					lowestCost = cost;
+					directionField[index] = FVector2D(x, y).GetSafeNormal();
+				}
+			}
+		}
+	}
+
+	builtOriginCell = originCell;
+	builtHeightBand = targetHeightBand;
+	bNeedsRebuild = false;
+	bIsValid = true;
+}
+
+bool FTrackerBotFlowField::SampleDirection(const FVector& Location, FVector& OutDirection) const
+{
+	//bots on another floor aren't covered by the navigable cells of the field
+	if (!bIsValid || GetHeightBand(Location.Z) != builtHeightBand)
+		return false;
+
+	const FIntPoint gridCell = GetCell(Location) - builtOriginCell;
+	if (!isInGrid(gridCell))
+		return false;
+
+	const FVector2D& direction = directionField[getIndex(gridCell)];
+	if (direction.IsZero())
+		return false;
+
+	OutDirection = FVector(direction, 0.f);
+	return true;
+}
+
+FIntPoint FTrackerBotFlowField::GetCell(const FVector& Location)
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+int32 FTrackerBotFlowField::GetHeightBand(float Height)
+{
+	return FMath::FloorToInt(Height / HeightBandSize);
+}
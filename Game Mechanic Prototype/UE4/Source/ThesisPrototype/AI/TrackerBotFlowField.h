@@ -0,0 +1,53 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UNavigationSystemV1;
+class ANavigationData;
+
+/**
+ * Flow field around a target on a horizontal grid, so any number of tracker bots can chase the target by sampling a direction.
+ * The grid is centered on the target and integrated from the target cell whenever the target enters another cell.
+ * Which cells are navigable is projected to the navmesh once per height band and shared between all flow fields.
+ */
+struct THESISPROTOTYPE_API FTrackerBotFlowField
+{
+	static const int32 GridSize = 64;
+	static const float CellSize;
+	//the navigable cells are cached per cell and height band, so floors above each other don't share the projection
+	static const float HeightBandSize;
+
+	//rebuilds the field if the target changed its cell, returns false while cells still need to be projected to the navmesh.
+	//at most NavigationSampleBudget cells are projected, the budget is reduced by the projected cells
+	bool Update(UNavigationSystemV1& NavigationSystem, const ANavigationData& NavigationData, const FVector& TargetLocation, TMap<FIntVector, bool>& NavigableCells, int32& NavigationSampleBudget);
+
+	//rebuilds the field with the next update, e.g., after the navmesh changed. the current field stays valid until then
+	FORCEINLINE void Invalidate() { bNeedsRebuild = true; }
+
+	//normalized direction towards the target, false if the location is outside of the field or its height band, not reachable or in the target cell
+	bool SampleDirection(const FVector& Location, FVector& OutDirection) const;
+
+	static FIntPoint GetCell(const FVector& Location);
+	static int32 GetHeightBand(float Height);
+
+private:
+	void integrate(const TMap<FIntVector, bool>& NavigableCells);
+	FORCEINLINE int32 getIndex(const FIntPoint& GridCell) const { return GridCell.Y * GridSize + GridCell.X; }
+	FORCEINLINE bool isInGrid(const FIntPoint& GridCell) const { return GridCell.X >= 0 && GridCell.Y >= 0 && GridCell.X < GridSize && GridCell.Y < GridSize; }
+
+private:
+	bool bIsValid = false;
+	bool bNeedsRebuild = true;
+	FIntPoint targetCell = FIntPoint(MAX_int32, MAX_int32);
+	//world cell of the grid cell (0, 0) of the next build
+	FIntPoint originCell = FIntPoint::ZeroValue;
+	int32 targetHeightBand = 0;
+
+	//of the last build, the directions are normalized and zero in the target cell and in unreachable cells
+	FIntPoint builtOriginCell = FIntPoint::ZeroValue;
+	int32 builtHeightBand = 0;
+	TArray<int32> integrationField;
+	TArray<FVector2D> directionField;
+};
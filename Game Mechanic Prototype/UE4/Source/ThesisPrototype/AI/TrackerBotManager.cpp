@@ -0,0 +1,638 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "TrackerBotManager.h"
+#include "ShooterTrackerBot.h"
+#include "Components/HealthComponent.h"
+#include "ChangingGuns.h"
+#include "NavigationSystem.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+
+static int32 TrackerBotPathQueriesPerFrame = 4;
+FAutoConsoleVariableRef CVARTrackerBotPathQueriesPerFrame(
+	TEXT("Game.TrackerBotPathQueriesPerFrame"),
+	TrackerBotPathQueriesPerFrame,
+	TEXT("Maximum number of tracker bot path queries started per frame"),
+	ECVF_Default
+);
+
+static float TrackerBotPathCacheLifetime = 1.f;
+FAutoConsoleVariableRef CVARTrackerBotPathCacheLifetime(
+	TEXT("Game.TrackerBotPathCacheLifetime"),
+	TrackerBotPathCacheLifetime,
+	TEXT("Seconds a tracker bot path is shared with other bots"),
+	ECVF_Default
+);
+
+static int32 TrackerBotFlowField = 0;
+FAutoConsoleVariableRef CVARTrackerBotFlowField(
+	TEXT("Game.TrackerBotFlowField"),
+	TrackerBotFlowField,
+	TEXT("Tracker bots follow a flow field per target instead of requesting paths"),
+	ECVF_Default
+);
+
+static int32 TrackerBotFlowFieldSamplesPerFrame = 256;
+FAutoConsoleVariableRef CVARTrackerBotFlowFieldSamplesPerFrame(
+	TEXT("Game.TrackerBotFlowFieldSamplesPerFrame"),
+	TrackerBotFlowFieldSamplesPerFrame,
+	TEXT("Maximum number of flow field cells projected to the navmesh per frame"),
+	ECVF_Default
+);
+
+static int32 TrackerBotFlowFieldMaxCachedCells = 64 * 1024;
+FAutoConsoleVariableRef CVARTrackerBotFlowFieldMaxCachedCells(
+	TEXT("Game.TrackerBotFlowFieldMaxCachedCells"),
+	TrackerBotFlowFieldMaxCachedCells,
+	TEXT("Maximum number of navmesh projections of flow field cells which are cached, at least the cells of all current flow fields"),
+	ECVF_Default
+);
+
+static float TrackerBotAudioUpdateInterval = 0.1f;
+FAutoConsoleVariableRef CVARTrackerBotAudioUpdateInterval(
+	TEXT("Game.TrackerBotAudioUpdateInterval"),
+	TrackerBotAudioUpdateInterval,
+	TEXT("Seconds between updates of the tracker bot movement sound volume"),
+	ECVF_Default
+);
+
+static float TrackerBotAudioVolumeThreshold = 0.05f;
+FAutoConsoleVariableRef CVARTrackerBotAudioVolumeThreshold(
+	TEXT("Game.TrackerBotAudioVolumeThreshold"),
+	TrackerBotAudioVolumeThreshold,
+	TEXT("Minimum change of the tracker bot movement sound volume which is applied"),
+	ECVF_Default
+);
+
+static int32 TrackerBotTickLOD = 1;
+FAutoConsoleVariableRef CVARTrackerBotTickLOD(
+	TEXT("Game.TrackerBotTickLOD"),
+	TrackerBotTickLOD,
+	TEXT("Move tracker bots which are far away from their target or not visible at a lower rate"),
+	ECVF_Default
+);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tracker Bots Full Rate"), STAT_TrackerBotsFullRate, STATGROUP_ChangingGuns);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tracker Bots Medium Rate"), STAT_TrackerBotsMediumRate, STATGROUP_ChangingGuns);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tracker Bots Low Rate"), STAT_TrackerBotsLowRate, STATGROUP_ChangingGuns);
+
+ATrackerBotManager::ATrackerBotManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+}
+
+ATrackerBotManager* ATrackerBotManager::Get(UWorld* World)
+{
+	return TWorldSingleton<ATrackerBotManager>::Get(World);
+}
+
+ATrackerBotManager* ATrackerBotManager::Find(UWorld* World)
+{
+	return TWorldSingleton<ATrackerBotManager>::Find(World);
+}
+
+void ATrackerBotManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	//bots register right after the manager is spawned, maybe before it begins play
+	randomStream.Initialize(FSessionSeed::NextStreamSeed(TEXT("TrackerBotManager")));
+}
+
+void ATrackerBotManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		navSys->OnNavigationGenerationFinishedDelegate.AddUniqueDynamic(this, &ATrackerBotManager::onNavigationGenerationFinished);
+	}
+}
+
+void ATrackerBotManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		navSys->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &ATrackerBotManager::onNavigationGenerationFinished);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATrackerBotManager::onNavigationGenerationFinished(ANavigationData* NavData)
+{
+	clearNavigableFlowFieldCells();
+}
+
+void ATrackerBotManager::RegisterBot(AShooterTrackerBot* Bot)
+{
+	if (Bot && !bots.Contains(Bot))
+	{
+		bots.Add(Bot);
+		//spreads the movement updates of the bots with a lower rate over the frames
+		botTimesSinceMovement.Add(randomStream.GetFraction() * lowRateInterval);
+	}
+}
+
+void ATrackerBotManager::UnregisterBot(AShooterTrackerBot* Bot)
+{
+	const int32 index = bots.Find(Bot);
+	if (index != INDEX_NONE)
+	{
+		bots.RemoveAtSwap(index, 1, false);
+		botTimesSinceMovement.RemoveAtSwap(index, 1, false);
+	}
+}
+
+void ATrackerBotManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	for (int32 i = bots.Num() - 1; i >= 0; --i)
+	{
+		if (!bots[i] || bots[i]->IsPendingKill())
+		{
+			bots.RemoveAtSwap(i, 1, false);
+			botTimesSinceMovement.RemoveAtSwap(i, 1, false);
+		}
+	}
+	updatePathQueries();
+	if (bots.Num() == 0)
+		return;
+
+	updateBotLocations();
+	updatePowerLevels();
+	updateTargets();
+	updateBotTargets();
+	updateFlowFields();
+	updateTickLODs();
+	updateMovement(DeltaTime);
+	updateMovementAudio(DeltaTime);
+}
+
+AActor* ATrackerBotManager::FindNearestTarget(const FVector& Location)
+{
+	updateTargets();
+	const int32 targetIndex = findNearestTargetIndex(Location);
+	return targetIndex != INDEX_NONE ? targets[targetIndex].Get() : nullptr;
+}
+
+void ATrackerBotManager::updateBotLocations()
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::BotTick);
+	botLocations.SetNumUninitialized(bots.Num(), false);
+	botVelocities.SetNumUninitialized(bots.Num(), false);
+	for (int32 i = 0; i < bots.Num(); ++i)
+	{
+		botLocations[i] = bots[i]->GetActorLocation();
+		botVelocities[i] = bots[i]->GetVelocity();
+	}
+}
+
+void ATrackerBotManager::updatePowerLevels()
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::Overlaps);
+	const int32 numBots = bots.Num();
+
+	sortedCellBots.Reset();
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		sortedCellBots.Add(TPair<uint64, int32>(getCellKey(getCell(botLocations[i], nearbyBotRadius)), i));
+	}
+	sortedCellBots.Sort([](const TPair<uint64, int32>& A, const TPair<uint64, int32>& B) { return A.Key < B.Key; });
+
+	cellRanges.Reset();
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		TPair<int32, int32>& range = cellRanges.FindOrAdd(sortedCellBots[i].Key);
+		if (range.Value == 0)
+		{
+			range.Key = i;
+		}
+		++range.Value;
+	}
+
+	//the cells are as big as the radius, so all nearby bots are in the neighbouring cells
+	const float radiusSquared = FMath::Square(nearbyBotRadius);
+	numNearbyBots.SetNumZeroed(numBots, false);
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		const FVector& location = botLocations[i];
+		const FIntVector cell = getCell(location, nearbyBotRadius);
+		int32 numNearby = 0;
+		for (int32 x = -1; x <= 1; ++x)
+		{
+			for (int32 y = -1; y <= 1; ++y)
+			{
+				for (int32 z = -1; z <= 1; ++z)
+				{
+					const TPair<int32, int32>* range = cellRanges.Find(getCellKey(cell + FIntVector(x, y, z)));
+					if (!range)
+						continue;
+
+					for (int32 j = range->Key; j < range->Key + range->Value; ++j)
+					{
+						const int32 other = sortedCellBots[j].Value;
+						numNearby += other != i && FVector::DistSquared(location, botLocations[other]) <= radiusSquared ? 1 : 0;
+					}
+				}
+			}
+		}
+		numNearbyBots[i] = numNearby;
+	}
+
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		bots[i]->UpdatePowerLevel(numNearbyBots[i], nearbyBotRadius);
+	}
+}
+
+void ATrackerBotManager::updateTargets()
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::BotTick);
+	if (targetsUpdateFrame == GFrameCounter)
+		return;
+	targetsUpdateFrame = GFrameCounter;
+
+	targets.Reset();
+	targetLocationsX.Reset();
+	targetLocationsY.Reset();
+	targetLocationsZ.Reset();
+
+	for (FConstPawnIterator it = GetWorld()->GetPawnIterator(); it; ++it)
+	{
+		APawn* pawn = it->Get();
+		const UHealthComponent* healthComp = UHealthComponent::FindHealthComponent(pawn);
+		if (!healthComp || healthComp->GetHealth() <= 0.f || UHealthComponent::AreTeamsFriendly(TEAMNUMBER_BOT, healthComp->GetTeamNumber()))
+			continue;
+
+		const FVector location = pawn->GetActorLocation();
+		targets.Add(pawn);
+		targetLocationsX.Add(location.X);
+		targetLocationsY.Add(location.Y);
+		targetLocationsZ.Add(location.Z);
+	}
+}
+
+void ATrackerBotManager::updateBotTargets()
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::BotTick);
+	botTargetIndices.SetNumUninitialized(bots.Num(), false);
+	for (int32 i = 0; i < bots.Num(); ++i)
+	{
+		const int32 targetIndex = findNearestTargetIndex(botLocations[i]);
+		botTargetIndices[i] = targetIndex;
+		bots[i]->SetNearestTarget(targetIndex != INDEX_NONE ? targets[targetIndex].Get() : nullptr);
+	}
+}
+
+int32 ATrackerBotManager::findNearestTargetIndex(const FVector& Location) const
+{
+	const int32 numTargets = targets.Num();
+	const float* x = targetLocationsX.GetData();
+	const float* y = targetLocationsY.GetData();
+	const float* z = targetLocationsZ.GetData();
+
+	int32 nearestIndex = INDEX_NONE;
+	float nearestDistanceSquared = MAX_flt;
+	for (int32 i = 0; i < numTargets; ++i)
+	{
+		const float dx = x[i] - Location.X;
+		const float dy = y[i] - Location.Y;
+		const float dz = z[i] - Location.Z;
+		const float distanceSquared = dx * dx + dy * dy + dz * dz;
+		nearestIndex = distanceSquared < nearestDistanceSquared ? i : nearestIndex;
+		nearestDistanceSquared = FMath::Min(distanceSquared, nearestDistanceSquared);
+	}
+	return nearestIndex;
+}
+
+void ATrackerBotManager::RequestPath(AShooterTrackerBot* Bot, AActor* Target)
+{
+	if (!Bot || !Target)
+		return;
+
+	const FVector start = Bot->GetActorLocation();
+	const INavAgentInterface* targetAgent = Cast<INavAgentInterface>(Target);
+	const FVector end = targetAgent ? targetAgent->GetNavAgentLocation() : Target->GetActorLocation();
+
+	FPathCacheKey key;
+	key.StartCell = getCell(start, pathCacheCellSize);
+	key.TargetCell = getCell(end, pathCacheCellSize);
+	key.Target = FObjectKey(Target);
+
+	FCachedPath& cachedPath = pathCache.FindOrAdd(key);
+	if (!cachedPath.bIsPending)
+	{
+		if (cachedPath.bHasResult && GetWorld()->TimeSeconds - cachedPath.Time <= TrackerBotPathCacheLifetime)
+		{
+			Bot->OnPathFound(cachedPath.PathPoints);
+			return;
+		}
+
+		//the first bot defines the start of the shared path
+		cachedPath.Start = start;
+		cachedPath.End = end;
+		cachedPath.bIsPending = true;
+		queuedPathQueries.Add(key);
+	}
+	cachedPath.WaitingBots.AddUnique(Bot);
+}
+
+void ATrackerBotManager::updatePathQueries()
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::Pathfinding);
+	const float time = GetWorld()->TimeSeconds;
+	for (auto it = pathCache.CreateIterator(); it; ++it)
+	{
+		if (!it.Value().bIsPending && (time - it.Value().Time > TrackerBotPathCacheLifetime || !it.Key().Target.ResolveObjectPtr()))
+		{
+			it.RemoveCurrent();
+		}
+	}
+
+	UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	int32 numStartedQueries = 0;
+	for (; numStartedQueries < queuedPathQueries.Num() && numStartedQueries < TrackerBotPathQueriesPerFrame; ++numStartedQueries)
+	{
+		const FPathCacheKey& key = queuedPathQueries[numStartedQueries];
+		const FCachedPath* cachedPath = pathCache.Find(key);
+		if (!cachedPath)
+			continue;
+
+		//like UNavigationSystemV1::FindPathToActorSynchronously, but with the navigation data of the first waiting bot
+		const AShooterTrackerBot* bot = cachedPath->WaitingBots.Num() > 0 ? cachedPath->WaitingBots[0].Get() : nullptr;
+		ANavigationData* navData = navSys && bot ? navSys->GetNavDataForProps(bot->GetNavAgentPropertiesRef()) : nullptr;
+		if (!navData && navSys)
+		{
+			navData = navSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate);
+		}
+		//the target has been destroyed while the query was queued
+		if (!bot || !navData || !key.Target.ResolveObjectPtr())
+		{
+			finishPath(key, nullptr);
+			continue;
+		}
+
+		FPathFindingQuery query(bot, *navData, cachedPath->Start, cachedPath->End, UNavigationQueryFilter::GetQueryFilter(*navData, bot, nullptr));
+		navSys->FindPathAsync(bot->GetNavAgentPropertiesRef(), query, FNavPathQueryDelegate::CreateUObject(this, &ATrackerBotManager::onPathQueryFinished, key));
+	}
+	queuedPathQueries.RemoveAt(0, numStartedQueries, false);
+}
+
+void ATrackerBotManager::onPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path, FPathCacheKey Key)
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::Pathfinding);
+	finishPath(Key, Result == ENavigationQueryResult::Success ? Path : nullptr);
+}
+
+void ATrackerBotManager::finishPath(const FPathCacheKey& Key, FNavPathSharedPtr Path)
+{
+	FCachedPath* cachedPath = pathCache.Find(Key);
+	if (!cachedPath)
+		return;
+
+	cachedPath->bIsPending = false;
+	cachedPath->bHasResult = true;
+	cachedPath->Time = GetWorld()->TimeSeconds;
+	cachedPath->PathPoints.Reset();
+	if (Path.IsValid())
+	{
+		for (const FNavPathPoint& pathPoint : Path->GetPathPoints())
+		{
+			cachedPath->PathPoints.Add(pathPoint.Location);
+		}
+	}
+
+	const TArray<FVector> pathPoints = cachedPath->PathPoints;
+	const TArray<TWeakObjectPtr<AShooterTrackerBot>> waitingBots = MoveTemp(cachedPath->WaitingBots);
+	cachedPath->WaitingBots.Reset();
+	for (const TWeakObjectPtr<AShooterTrackerBot>& bot : waitingBots)
+	{
+		if (bot.IsValid())
+		{
+			bot->OnPathFound(pathPoints);
+		}
+	}
+}
+
+void ATrackerBotManager::updateFlowFields()
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::Pathfinding);
+	if (TrackerBotFlowField <= 0)
+	{
+		flowFields.Reset();
+		return;
+	}
+
+	UNavigationSystemV1* navSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* navData = navSys ? navSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+	if (!navData)
+		return;
+
+	for (auto it = flowFields.CreateIterator(); it; ++it)
+	{
+		const FObjectKey target = it.Key();
+		if (!target.ResolveObjectPtr() || !targets.ContainsByPredicate([target](const TWeakObjectPtr<AActor>& Other) { return FObjectKey(Other.Get()) == target; }))
+		{
+			it.RemoveCurrent();
+		}
+	}
+
+	//a full cache is rebuilt from scratch, but it always fits the cells of the flow fields of all targets
+	const int32 maxCachedCells = FMath::Max(TrackerBotFlowFieldMaxCachedCells, targets.Num() * FTrackerBotFlowField::GridSize * FTrackerBotFlowField::GridSize);
+	if (navigableFlowFieldCells.Num() > maxCachedCells)
+	{
+		clearNavigableFlowFieldCells();
+	}
+
+	int32 sampleBudget = TrackerBotFlowFieldSamplesPerFrame;
+	for (const TWeakObjectPtr<AActor>& target : targets)
+	{
+		if (target.IsValid())
+		{
+			flowFields.FindOrAdd(FObjectKey(target.Get())).Update(*navSys, *navData, target->GetActorLocation(), navigableFlowFieldCells, sampleBudget);
+		}
+	}
+}
+
+bool ATrackerBotManager::SampleFlowField(const AActor* Target, const FVector& Location, FVector& OutPathPoint) const
+{
+	if (TrackerBotFlowField <= 0 || !Target)
+		return false;
+
+	const FTrackerBotFlowField* flowField = flowFields.Find(FObjectKey(Target));
+	FVector flowDirection;
+	if (!flowField || !flowField->SampleDirection(Location, flowDirection))
+		return false;
+
+	OutPathPoint = Location + flowDirection * FTrackerBotFlowField::CellSize * 2.f;
+	return true;
+}
+
+void ATrackerBotManager::clearNavigableFlowFieldCells()
+{
+	navigableFlowFieldCells.Reset();
+	for (auto& flowField : flowFields)
+	{
+		flowField.Value.Invalidate();
+	}
+}
+
+void ATrackerBotManager::updateTickLODs()
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::BotTick);
+	const int32 numBots = bots.Num();
+	botTickLODs.SetNumUninitialized(numBots, false);
+	if (TrackerBotTickLOD <= 0)
+	{
+		FMemory::Memzero(botTickLODs.GetData(), numBots);
+		SET_DWORD_STAT(STAT_TrackerBotsFullRate, numBots);
+		SET_DWORD_STAT(STAT_TrackerBotsMediumRate, 0);
+		SET_DWORD_STAT(STAT_TrackerBotsLowRate, 0);
+		return;
+	}
+
+	//nothing is rendered on a dedicated server or without a renderer, e.g., -nullrhi
+	const bool bUseVisibility = FApp::CanEverRender() && GetNetMode() != NM_DedicatedServer;
+	const float fullRateDistanceSquared = FMath::Square(fullRateDistance);
+	const float mediumRateDistanceSquared = FMath::Square(mediumRateDistance);
+	int32 numBotsPerLOD[3] = { 0, 0, 0 };
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		const int32 targetIndex = botTargetIndices[i];
+		const float distanceSquared = targetIndex != INDEX_NONE
+			? FVector::DistSquared(botLocations[i], FVector(targetLocationsX[targetIndex], targetLocationsY[targetIndex], targetLocationsZ[targetIndex]))
+			: MAX_flt;
+
+		uint8 lod = distanceSquared <= fullRateDistanceSquared ? 0 : distanceSquared <= mediumRateDistanceSquared ? 1 : 2;
+		if (bUseVisibility && lod < 2 && !bots[i]->WasRecentlyRendered(0.2f))
+		{
+			++lod;
+		}
+		botTickLODs[i] = lod;
+		++numBotsPerLOD[lod];
+	}
+
+	SET_DWORD_STAT(STAT_TrackerBotsFullRate, numBotsPerLOD[0]);
+	SET_DWORD_STAT(STAT_TrackerBotsMediumRate, numBotsPerLOD[1]);
+	SET_DWORD_STAT(STAT_TrackerBotsLowRate, numBotsPerLOD[2]);
+}
+
+void ATrackerBotManager::updateMovement(float DeltaTime)
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::BotTick);
+	const int32 numBots = bots.Num();
+
+	//0 = skipped this frame, otherwise the time the movement of the bot has to cover
+	botMovementDurations.SetNumUninitialized(numBots, false);
+	const float lodIntervals[3] = { 0.f, mediumRateInterval, lowRateInterval };
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		botTimesSinceMovement[i] += DeltaTime;
+		if (botTimesSinceMovement[i] >= lodIntervals[botTickLODs[i]])
+		{
+			botMovementDurations[i] = botTimesSinceMovement[i];
+			botTimesSinceMovement[i] = 0.f;
+		}
+		else
+		{
+			botMovementDurations[i] = 0.f;
+		}
+	}
+
+	botPathPoints.SetNumUninitialized(numBots, false);
+	botForceMagnitudes.SetNumUninitialized(numBots, false);
+	botRequiredDistances.SetNumUninitialized(numBots, false);
+	botMovementForces.SetNumUninitialized(numBots, false);
+	botReachedPathPoints.SetNumUninitialized(numBots, false);
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		botPathPoints[i] = bots[i]->GetNextPathPoint();
+		botForceMagnitudes[i] = bots[i]->GetMovementForce();
+		botRequiredDistances[i] = bots[i]->GetRequiredDistanceToTarget();
+	}
+
+	//the flow field replaces the path if it covers the bot, bots which leave it request a path again
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		if (botMovementDurations[i] <= 0.f)
+			continue;
+
+		const AActor* target = botTargetIndices[i] != INDEX_NONE ? targets[botTargetIndices[i]].Get() : nullptr;
+		if (SampleFlowField(target, botLocations[i], botPathPoints[i]))
+		{
+			bots[i]->FollowFlowField(botPathPoints[i]);
+		}
+		else if (bots[i]->IsFollowingFlowField())
+		{
+			bots[i]->OnFlowFieldLeft();
+			botPathPoints[i] = bots[i]->GetNextPathPoint();
+		}
+	}
+
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		const FVector toPathPoint = botPathPoints[i] - botLocations[i];
+		const float distance = toPathPoint.Size();
+		botReachedPathPoints[i] = distance <= botRequiredDistances[i];
+		botMovementForces[i] = distance > SMALL_NUMBER ? toPathPoint * (botForceMagnitudes[i] / distance) : FVector::ZeroVector;
+	}
+
+	//the bots can request paths, so the forces are applied after all of them have been computed
+
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		if (botMovementDurations[i] <= 0.f)
+			continue;
+
+		if (botReachedPathPoints[i])
+		{
+			bots[i]->OnPathPointReached();
+		}
+		else
+		{
+			//bots which are moved every frame get a regular force, the others the force of all frames since their last movement
+			bots[i]->AddMovementForce(botMovementForces[i], botTickLODs[i] == 0 ? 0.f : botMovementDurations[i]);
+		}
+	}
+}
+
+void ATrackerBotManager::updateMovementAudio(float DeltaTime)
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::BotTick);
+	timeSinceMovementAudioUpdate += DeltaTime;
+	if (timeSinceMovementAudioUpdate < TrackerBotAudioUpdateInterval)
+		return;
+	timeSinceMovementAudioUpdate = 0.f;
+
+	const int32 numBots = bots.Num();
+	botMovementVolumes.SetNumUninitialized(numBots, false);
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		botMovementVolumes[i] = FMath::GetMappedRangeValueClamped(FVector2D(10.f, 1000.f), FVector2D(0.1f, 2.f), botVelocities[i].Size());
+	}
+
+	for (int32 i = 0; i < numBots; ++i)
+	{
+		bots[i]->UpdateMovementVolume(botMovementVolumes[i], TrackerBotAudioVolumeThreshold);
+	}
+}
+
+uint64 ATrackerBotManager::getCellKey(const FIntVector& Cell)
+{
+	//21 bits per axis are plenty for any level size
+	const uint64 mask = (1 << 21) - 1;
+	const uint64 offset = 1 << 20;
+	return ((Cell.X + offset) & mask) | (((Cell.Y + offset) & mask) << 21) | (((Cell.Z + offset) & mask) << 42);
+}
+
+FIntVector ATrackerBotManager::getCell(const FVector& Location, float CellSize)
+{
+	return FIntVector(
+		FMath::FloorToInt(Location.X / CellSize),
+		FMath::FloorToInt(Location.Y / CellSize),
+		FMath::FloorToInt(Location.Z / CellSize));
+}
@@ -0,0 +1,181 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "UObject/ObjectKey.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "TrackerBotFlowField.h"
+#include "ChangingGuns.h"
+#include "TrackerBotManager.generated.h"
+
+class AShooterTrackerBot;
+class ANavigationData;
+
+/**
+ * Updates all tracker bots of a world together instead of letting every bot query the world on its own.
+ * Once per frame it puts the bots into a uniform grid and counts the nearby bots of every bot for its power level,
+ * which replaces an overlap query per bot, and it selects the nearest hostile target of every bot in one pass over all targets.
+ * Paths are found asynchronously, shared by bots which start nearby and chase the same target and limited to a budget per frame.
+ * Optionally (Game.TrackerBotFlowField) the bots follow a flow field per target and request paths only outside of it.
+ * The bots don't tick, the manager applies the movement forces of all bots in one loop and updates their movement sound at a lower rate.
+ * Bots which are far away from their target or haven't been rendered recently are moved at a lower rate (Game.TrackerBotTickLOD).
+ */
+UCLASS(NotBlueprintable)
+class THESISPROTOTYPE_API ATrackerBotManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ATrackerBotManager();
+
+	//see TWorldSingleton
+	static ATrackerBotManager* Get(UWorld* World);
+	static ATrackerBotManager* Find(UWorld* World);
+
+	void RegisterBot(AShooterTrackerBot* Bot);
+	void UnregisterBot(AShooterTrackerBot* Bot);
+
+	virtual void Tick(float DeltaTime) override;
+
+	//nearest alive pawn which is hostile to the bots, e.g., for bots which haven't been updated by the manager yet
+	AActor* FindNearestTarget(const FVector& Location);
+
+	//the path is passed to AShooterTrackerBot::OnPathFound, right away if there is a recent one from nearby to the same target
+	void RequestPath(AShooterTrackerBot* Bot, AActor* Target);
+
+	//next path point along the flow field of Target, false if flow fields are disabled or the field doesn't cover Location.
+	//bots which are covered don't request paths
+	bool SampleFlowField(const AActor* Target, const FVector& Location, FVector& OutPathPoint) const;
+
+protected:
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//the navigable flow field cells are projected again after the navmesh changed
+	UFUNCTION()
+	void onNavigationGenerationFinished(ANavigationData* NavData);
+
+	void updateBotLocations();
+	//collects the alive hostile pawns once per frame
+	void updateTargets();
+	//assigns every bot its nearest target
+	void updateBotTargets();
+	int32 findNearestTargetIndex(const FVector& Location) const;
+	//counts the bots within nearbyBotRadius of every bot with a uniform grid of nearbyBotRadius sized cells
+	void updatePowerLevels();
+
+	//starts the queued path queries within the budget of the frame and removes old paths
+	void updatePathQueries();
+	//keeps a flow field for every target while flow fields are enabled
+	void updateFlowFields();
+	//the flow fields are rebuilt with the next update
+	void clearNavigableFlowFieldCells();
+	//assigns every bot a tick LOD by the distance to its target and its visibility
+	void updateTickLODs();
+	//moves every bot towards its next path point or along the flow field of its target
+	void updateMovement(float DeltaTime);
+	//maps the speed of every bot to the volume of its movement sound
+	void updateMovementAudio(float DeltaTime);
+
+	static uint64 getCellKey(const FIntVector& Cell);
+	static FIntVector getCell(const FVector& Location, float CellSize);
+
+	struct FPathCacheKey
+	{
+		FIntVector StartCell;
+		FIntVector TargetCell;
+		//doesn't alias a new actor at the address of a destroyed target
+		FObjectKey Target;
+
+		bool operator==(const FPathCacheKey& Other) const
+		{
+			return StartCell == Other.StartCell && TargetCell == Other.TargetCell && Target == Other.Target;
+		}
+
+		friend uint32 GetTypeHash(const FPathCacheKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.StartCell), GetTypeHash(Key.TargetCell)), GetTypeHash(Key.Target));
+		}
+	};
+
+	struct FCachedPath
+	{
+		TArray<FVector> PathPoints;
+		FVector Start;
+		FVector End;
+		//world time of the result
+		float Time = 0.f;
+		bool bHasResult = false;
+		bool bIsPending = false;
+		TArray<TWeakObjectPtr<AShooterTrackerBot>> WaitingBots;
+	};
+
+	void onPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path, FPathCacheKey Key);
+	void finishPath(const FPathCacheKey& Key, FNavPathSharedPtr Path);
+
+protected:
+	//bots within this distance boost each other's power level
+	UPROPERTY(EditDefaultsOnly, Category = "Tracker Bot Manager", meta = (ClampMin = 1.0))
+	float nearbyBotRadius = 600.f;
+
+	//bots within this distance to their target are moved every frame
+	UPROPERTY(EditDefaultsOnly, Category = "Tracker Bot Manager|Tick LOD", meta = (ClampMin = 0.0))
+	float fullRateDistance = 20.f * PROJECT_MEASURING_UNIT_FACTOR_TO_M;
+
+	//bots within this distance to their target are moved every mediumRateInterval seconds, the others every lowRateInterval seconds
+	UPROPERTY(EditDefaultsOnly, Category = "Tracker Bot Manager|Tick LOD", meta = (ClampMin = 0.0))
+	float mediumRateDistance = 60.f * PROJECT_MEASURING_UNIT_FACTOR_TO_M;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Tracker Bot Manager|Tick LOD", meta = (ClampMin = 0.0))
+	float mediumRateInterval = 0.1f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Tracker Bot Manager|Tick LOD", meta = (ClampMin = 0.0))
+	float lowRateInterval = 0.5f;
+
+	UPROPERTY(Transient)
+	TArray<AShooterTrackerBot*> bots;
+
+	//per frame data in the order of bots
+	TArray<FVector> botLocations;
+	TArray<FVector> botVelocities;
+	TArray<int32> numNearbyBots;
+	TArray<int32> botTargetIndices;
+	TArray<FVector> botPathPoints;
+	TArray<float> botForceMagnitudes;
+	TArray<float> botRequiredDistances;
+	TArray<FVector> botMovementForces;
+	TArray<bool> botReachedPathPoints;
+	TArray<float> botMovementVolumes;
+	//0 = full rate, 1 = medium rate, 2 = low rate
+	TArray<uint8> botTickLODs;
+	//kept in the order of bots across frames
+	TArray<float> botTimesSinceMovement;
+	TArray<float> botMovementDurations;
+	float timeSinceMovementAudioUpdate = 0.f;
+	//derived from the session seed, so the bots are spread over the same frames in every run
+	FRandomStream randomStream;
+
+	//alive hostile pawns of the current frame, the locations are stored per axis so the distance loop vectorizes
+	TArray<TWeakObjectPtr<AActor>> targets;
+	TArray<float> targetLocationsX;
+	TArray<float> targetLocationsY;
+	TArray<float> targetLocationsZ;
+	uint64 targetsUpdateFrame = MAX_uint64;
+
+	//grid of the current frame, the indices of the bots sorted by cell and the range of every cell in it
+	TArray<TPair<uint64, int32>> sortedCellBots;
+	TMap<uint64, TPair<int32, int32>> cellRanges;
+
+	//bots which start within the same cell share the path to the same target
+	float pathCacheCellSize = 200.f;
+	TMap<FPathCacheKey, FCachedPath> pathCache;
+	TArray<FPathCacheKey> queuedPathQueries;
+
+	//per target, the fields of destroyed targets are removed with the next update
+	TMap<FObjectKey, FTrackerBotFlowField> flowFields;
+	//navmesh projection of the flow field cells per height band, shared by all flow fields and cleared if it grows beyond Game.TrackerBotFlowFieldMaxCachedCells
+	TMap<FIntVector, bool> navigableFlowFieldCells;
+};
@@ -2,5 +2,68 @@
 
 #include "ChangingGuns.h"
 #include "Modules/ModuleManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Crc.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, ThesisPrototype, "ThesisPrototype" );
+
+static int32 SessionSeed = 0;
+FAutoConsoleVariableRef CVARSessionSeed(
+	TEXT("Game.SessionSeed"),
+	SessionSeed,
+	TEXT("Seed of all weapon and weapon generator random streams of the next session, 0 picks a random one"),
+	ECVF_Default
+);
+
+static int32 DeterministicSimulation = 0;
+FAutoConsoleVariableRef CVARDeterministicSimulation(
+	TEXT("Game.DeterministicSimulation"),
+	DeterministicSimulation,
+	TEXT("Generate weapons inline and without the prefetch pool, so the same session seed and input always produce the same weapons"),
+	ECVF_Default
+);
+
+static uint32 CurrentSessionSeed = 0;
+static TMap<FString, uint32> NumStreamsPerName;
+
+void FSessionSeed::Reset()
+{
+	CurrentSessionSeed = SessionSeed != 0 ? static_cast<uint32>(SessionSeed) : FPlatformTime::Cycles();
+	NumStreamsPerName.Reset();
+	UE_LOG(LogTemp, Log, TEXT("Session seed: %u"), CurrentSessionSeed);
+}
+
+uint32 FSessionSeed::Get()
+{
+	if (CurrentSessionSeed == 0)
+	{
+		Reset();
+	}
+	return CurrentSessionSeed;
+}
+
+int32 FSessionSeed::NextStreamSeed(const TCHAR* StreamName)
+{
+	//the crc of the name is the same in every run, unlike the hash of a FName
+	uint32& numStreams = NumStreamsPerName.FindOrAdd(StreamName);
+	const uint32 seed = HashCombine(HashCombine(Get(), FCrc::StrCrc32(StreamName)), numStreams++);
+	return static_cast<int32>(seed);
+}
+
+bool FSessionSeed::IsDeterministic()
+{
+	return DeterministicSimulation > 0;
+}
+
+static FGameFrameTimings* ActiveGameFrameTimings = nullptr;
+
+void FGameFrameTimings::SetActive(FGameFrameTimings* Timings)
+{
+	ActiveGameFrameTimings = Timings;
+}
+
+FGameFrameTimings* FGameFrameTimings::GetActive()
+{
+	return ActiveGameFrameTimings;
+}
@@ -3,6 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/PlatformTime.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
 
 #define SURFACE_FLESHDEFAULT				SurfaceType1
 #define SURFACE_FLESHLOWERBOYDANDARMS		SurfaceType2
@@ -19,4 +23,109 @@
 
 #define TEAMNUMBER_ENVIRONMENT			253
 
-#define PROJECT_MEASURING_UNIT_FACTOR_TO_M		100 //the project uses CM as measuring unit
\ No newline at end of file
+#define PROJECT_MEASURING_UNIT_FACTOR_TO_M		100 //the project uses CM as measuring unit
+
+DECLARE_STATS_GROUP(TEXT("ChangingGuns"), STATGROUP_ChangingGuns, STATCAT_Advanced);
+
+/**
+ * Lookup of the actors which exist once per world and serve all other actors of it, e.g., the weapon and effect pools and the tracker bot manager.
+ * Get spawns the actor with its first call, so it never has to be placed in a map, Find doesn't, e.g., while the world is torn down.
+ */
+template<typename TActorType>
+struct TWorldSingleton
+{
+	static TActorType* Find(UWorld* World)
+	{
+		if (!World)
+			return nullptr;
+
+		for (TActorIterator<TActorType> it(World); it; ++it)
+		{
+			if (!it->IsPendingKill())
+			{
+				return *it;
+			}
+		}
+		return nullptr;
+	}
+
+	static TActorType* Get(UWorld* World)
+	{
+		if (TActorType* actor = Find(World))
+			return actor;
+
+		if (!World)
+			return nullptr;
+
+		FActorSpawnParameters spawnParams;
+		spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		return World->SpawnActor<TActorType>(spawnParams);
+	}
+};
+
+/**
+ * Seed of all random streams of a play session (Game.SessionSeed, random if 0), every weapon and weapon generator derives its own stream from it.
+ * With the same seed and the same input a session generates the same weapons and shot patterns.
+ */
+struct THESISPROTOTYPE_API FSessionSeed
+{
+	//starts a new session, called by the game mode before anything begins play
+	static void Reset();
+	static uint32 Get();
+
+	//seed of the next stream of the kind, e.g., of the next weapon which begins play, derived from the session seed and the number of previous streams of the kind
+	static int32 NextStreamSeed(const TCHAR* StreamName);
+
+	//Game.DeterministicSimulation, work which would depend on the timing of background threads runs inline instead
+	static bool IsDeterministic();
+};
+
+//systems whose game thread time is collected by FGameFrameTimings
+enum class EGameFrameTiming : uint8
+{
+	//the work of the tracker bot manager which replaced the bot ticks, i.e., targets, tick LODs and movement
+	BotTick,
+	//path queries, their results and flow fields, the async path finding itself runs on other threads
+	Pathfinding,
+	//nearby bots of the power levels and the radial damage of exploding bots
+	Overlaps,
+	//live bot and player counters and the wave state of the game mode
+	GameMode,
+	Num
+};
+
+/**
+ * Game thread time of the bot and game mode systems, collected while set with SetActive, e.g., by the wave stress test of the game mode.
+ */
+struct THESISPROTOTYPE_API FGameFrameTimings
+{
+	uint64 Cycles[static_cast<int32>(EGameFrameTiming::Num)] = {};
+
+	//nullptr stops the collection
+	static void SetActive(FGameFrameTimings* Timings);
+	static FGameFrameTimings* GetActive();
+};
+
+//adds the cycles of the scope to the active timings
+struct FScopedGameFrameTiming
+{
+	explicit FScopedGameFrameTiming(EGameFrameTiming InTiming)
+		: timings(FGameFrameTimings::GetActive())
+		, timing(InTiming)
+		, startCycles(timings ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FScopedGameFrameTiming()
+	{
+		if (timings)
+		{
+			timings->Cycles[static_cast<int32>(timing)] += FPlatformTime::Cycles64() - startCycles;
+		}
+	}
+
+private:
+	FGameFrameTimings* timings;
+	EGameFrameTiming timing;
+	uint64 startCycles;
+};
\ No newline at end of file
@@ -7,37 +7,227 @@
 #include "ChangingGunsGameState.h"
 #include "ChangingGunsPlayerState.h"
 #include "Pawns/ShooterCharacter.h"
+#include "AI/ShooterTrackerBot.h"
+#include "NavigationSystem.h"
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
 #include "ChangingGuns.h"
 
 AChangingGunsGameMode::AChangingGunsGameMode() : Super()
 {
+	//the wave state is updated by the live bot and player counters, no need to poll, the game mode only ticks during the stress test
 	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.TickInterval = 1.f;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	GameStateClass = AChangingGunsGameState::StaticClass();
 	PlayerStateClass = AChangingGunsPlayerState::StaticClass();
 
 	timeBetweenWaves = 2.f;
 	botsPerWaveMultiplier = 2;
+
+	stressTestBotClass = AShooterTrackerBot::StaticClass();
+}
+
+void AChangingGunsGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	stressTestWaves = FMath::Max(0, UGameplayStatics::GetIntOption(Options, TEXT("StressTestWaves"), 0));
+	if(!isStressTestRunning())
+	{
+		return;
+	}
+
+	botsPerWaveMultiplier = UGameplayStatics::GetIntOption(Options, TEXT("BotsPerWaveMultiplier"), botsPerWaveMultiplier);
+	if(UGameplayStatics::HasOption(Options, TEXT("BotSpawnInterval")))
+	{
+		botSpawnInterval = FMath::Max(0.01f, FCString::Atof(*UGameplayStatics::ParseOption(Options, TEXT("BotSpawnInterval"))));
+	}
+	if(UGameplayStatics::HasOption(Options, TEXT("StressTestWaveTimeout")))
+	{
+		stressTestWaveTimeout = FMath::Max(0.f, FCString::Atof(*UGameplayStatics::ParseOption(Options, TEXT("StressTestWaveTimeout"))));
+	}
+	stressTestLabel = UGameplayStatics::ParseOption(Options, TEXT("StressTestLabel"));
 }
 
 void AChangingGunsGameMode::StartPlay()
 {
+	//the actors derive their random streams from the session seed when they begin play
+	FSessionSeed::Reset();
+
 	Super::StartPlay();
 	gameState = GetGameState<AChangingGunsGameState>();
+	OnActorKilledEvent.AddDynamic(this, &AChangingGunsGameMode::onActorKilled);
 	prepareForNextWave();
+
+	if(isStressTestRunning())
+	{
+		UE_LOG(LogTemp, Display, TEXT("Wave stress test: %d waves, %d bots per wave multiplier, %.2f s spawn interval, %.0f s wave timeout"), stressTestWaves, botsPerWaveMultiplier, botSpawnInterval, stressTestWaveTimeout);
+		lastStressTestFrameTime = FPlatformTime::Seconds();
+		SetActorTickEnabled(true);
+	}
 }
 
 void AChangingGunsGameMode::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
-	checkWaveState();
-	checkAnyPlayerAlive();
+
+	recordStressTestFrame();
+}
+
+void AChangingGunsGameMode::SetPlayerDefaults(APawn* PlayerPawn)
+{
+	Super::SetPlayerDefaults(PlayerPawn);
+
+	//the pawn began play before it was possessed, so it might have been counted as bot
+	UHealthComponent* healthComp = UHealthComponent::FindHealthComponent(PlayerPawn);
+	UpdateLiveActor(healthComp);
+
+	//the stress test runs until the last wave, the bots still chase and explode at the players
+	if(healthComp && isStressTestRunning())
+	{
+		healthComp->SetHandleDamageEnabled(false);
+	}
+}
+
+void AChangingGunsGameMode::UpdateLiveActor(const UHealthComponent* HealthComponent)
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::GameMode);
+	if(!HealthComponent)
+	{
+		return;
+	}
+
+	FLiveActor liveActor;
+	liveActor.Type = determineLiveActorType(HealthComponent);
+	liveActor.TeamNumber = HealthComponent->GetTeamNumber();
+
+	ELiveActorType previousType = ELiveActorType::None;
+	if(FLiveActor* previousLiveActor = liveActors.Find(HealthComponent))
+	{
+		if(previousLiveActor->Type == liveActor.Type && previousLiveActor->TeamNumber == liveActor.TeamNumber)
+		{
+			return;
+		}
+		previousType = previousLiveActor->Type;
+		changeLiveCounter(*previousLiveActor, -1);
+		liveActors.Remove(HealthComponent);
+	}
+
+	if(liveActor.Type != ELiveActorType::None)
+	{
+		liveActors.Add(HealthComponent, liveActor);
+		changeLiveCounter(liveActor, 1);
+	}
+
+	if(previousType == ELiveActorType::Bot)
+	{
+		checkWaveState();
+	}
+	else if(previousType == ELiveActorType::Player)
+	{
+		checkAnyPlayerAlive();
+	}
+}
+
+void AChangingGunsGameMode::RemoveLiveActor(const UHealthComponent* HealthComponent)
+{
+	FScopedGameFrameTiming timing(EGameFrameTiming::GameMode);
+	FLiveActor liveActor;
+	if(!liveActors.RemoveAndCopyValue(HealthComponent, liveActor))
+	{
+		return;
+	}
+
+	changeLiveCounter(liveActor, -1);
+	if(liveActor.Type == ELiveActorType::Bot)
+	{
+		checkWaveState();
+	}
+	else
+	{
+		checkAnyPlayerAlive();
+	}
+}
+
+void AChangingGunsGameMode::HandleWaveStateChanged(EWaveState NewState, EWaveState OldState)
+{
+	if(NewState == EWaveState::BossFight)
+	{
+		GetWorldTimerManager().ClearTimer(timerHandle_BotSpawner);
+		GetWorldTimerManager().ClearTimer(timerHandle_NextWaveStart);
+	}
+	else if(OldState == EWaveState::BossFight)
+	{
+		checkWaveState();
+	}
+}
+
+int32 AChangingGunsGameMode::GetNumLiveBots(uint8 TeamNumber) const
+{
+	const int32* numBots = liveBotsPerTeam.Find(TeamNumber);
+	return numBots ? *numBots : 0;
+}
+
+int32 AChangingGunsGameMode::GetNumLivePlayers() const
+{
+	int32 numPlayers = 0;
+	for(const TPair<uint8, int32>& team : livePlayersPerTeam)
+	{
+		numPlayers += team.Value;
+	}
+	return numPlayers;
+}
+
+AChangingGunsGameMode::ELiveActorType AChangingGunsGameMode::determineLiveActorType(const UHealthComponent* HealthComponent) const
+{
+	const APawn* pawn = Cast<APawn>(HealthComponent->GetOwner());
+	if(!pawn || pawn->IsPendingKill() || HealthComponent->GetHealth() <= 0.f)
+	{
+		return ELiveActorType::None;
+	}
+
+	if(pawn->IsPlayerControlled())
+	{
+		return ELiveActorType::Player;
+	}
+
+	if(UHealthComponent::IsBotTeam(HealthComponent->GetTeamNumber()) && HealthComponent->IsHandlingDamage())
+	{
+		return ELiveActorType::Bot;
+	}
+	return ELiveActorType::None;
+}
+
+void AChangingGunsGameMode::changeLiveCounter(const FLiveActor& LiveActor, int32 Delta)
+{
+	TMap<uint8, int32>& counters = LiveActor.Type == ELiveActorType::Player ? livePlayersPerTeam : liveBotsPerTeam;
+	counters.FindOrAdd(LiveActor.TeamNumber) += Delta;
+}
+
+void AChangingGunsGameMode::onActorKilled(AActor* VictimActor, AActor* KillerActor, AController* KillerController)
+{
+	UpdateLiveActor(UHealthComponent::FindHealthComponent(VictimActor));
 }
 
 void AChangingGunsGameMode::spawnBotTimerElapsed()
 {
-	spawnNewBot();
+	if(isStressTestRunning())
+	{
+		spawnStressTestBot();
+	}
+	else
+	{
+		spawnNewBot();
+	}
 
 	--numOfBotsToSpawn;
 	if(numOfBotsToSpawn <= 0)
@@ -48,9 +238,28 @@ void AChangingGunsGameMode::spawnBotTimerElapsed()
 
 void AChangingGunsGameMode::startWave()
 {
+	if(isStressTestRunning() && waveCount >= stressTestWaves)
+	{
+		finishStressTest();
+		return;
+	}
+
 	++waveCount;
 	numOfBotsToSpawn = botsPerWaveMultiplier * waveCount;
-	GetWorldTimerManager().SetTimer(timerHandle_BotSpawner, this, &AChangingGunsGameMode::spawnBotTimerElapsed, 1.f, true, 0.f);
+	GetWorldTimerManager().SetTimer(timerHandle_BotSpawner, this, &AChangingGunsGameMode::spawnBotTimerElapsed, botSpawnInterval, true, 0.f);
+
+	if(isStressTestRunning())
+	{
+		FStressTestWave& wave = stressTestWaveResults[stressTestWaveResults.AddDefaulted()];
+		wave.NumBots = numOfBotsToSpawn;
+		//the array could have been reallocated
+		FGameFrameTimings::SetActive(&wave.Timings);
+
+		if(stressTestWaveTimeout > 0.f)
+		{
+			GetWorldTimerManager().SetTimer(timerHandle_StressTestWaveTimeout, this, &AChangingGunsGameMode::stressTestWaveTimedOut, stressTestWaveTimeout, false);
+		}
+	}
 
 	setWaveState(EWaveState::WaveInProgress);
 }
@@ -60,10 +269,14 @@ void AChangingGunsGameMode::endWave()
 	GetWorldTimerManager().ClearTimer(timerHandle_BotSpawner);
 
 	setWaveState(EWaveState::WaitingToComplete);
+
+	//all bots of the wave could be dead already
+	checkWaveState();
 }
 
 void AChangingGunsGameMode::prepareForNextWave()
 {
+	GetWorldTimerManager().ClearTimer(timerHandle_StressTestWaveTimeout);
 	GetWorldTimerManager().SetTimer(timerHandle_NextWaveStart, this, &AChangingGunsGameMode::startWave, timeBetweenWaves, false);
 
 	setWaveState(EWaveState::WaitingToStart);
@@ -71,10 +284,9 @@ void AChangingGunsGameMode::prepareForNextWave()
 
 void AChangingGunsGameMode::checkWaveState()
 {
-	if(gameState->GetWaveState() == EWaveState::BossFight)
+	//the game mode hasn't started yet or the bots don't matter anymore
+	if(!gameState || gameState->GetWaveState() == EWaveState::BossFight || gameState->GetWaveState() == EWaveState::GameOver)
 	{
-		GetWorldTimerManager().ClearTimer(timerHandle_BotSpawner);
-		GetWorldTimerManager().ClearTimer(timerHandle_NextWaveStart);
 		return;
 	}
 
@@ -85,23 +297,7 @@ void AChangingGunsGameMode::checkWaveState()
 		return;
 	}
 
-	bool bIsAnyBotAlive = false;
-	for(FConstPawnIterator it = GetWorld()->GetPawnIterator(); it; ++it)
-	{
-		APawn* testPawn = it->Get();
-		if(!testPawn || testPawn->IsPlayerControlled())
-		{
-			continue;
-		}
-		UHealthComponent* healthComp = Cast<UHealthComponent>(testPawn->GetComponentByClass(UHealthComponent::StaticClass()));
-		if(healthComp && healthComp->GetTeamNumber() == TEAMNUMBER_BOT && healthComp->IsHandlingDamage() && healthComp->GetHealth() > 0.f)
-		{
-			bIsAnyBotAlive = true;
-			break;
-		}
-	}
-
-	if(!bIsAnyBotAlive)
+	if(GetNumLiveBots(TEAMNUMBER_BOT) <= 0)
 	{
 		setWaveState(EWaveState::WaveComplete);
 		prepareForNextWave();
@@ -110,30 +306,165 @@ void AChangingGunsGameMode::checkWaveState()
 
 void AChangingGunsGameMode::checkAnyPlayerAlive()
 {
-	for(FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	if(!gameState || gameState->GetWaveState() == EWaveState::GameOver)
 	{
-		APlayerController* pc = it->Get();
-		if(pc && pc->GetPawn())
-		{
-			APawn* pawn = pc->GetPawn();
-			UHealthComponent* healthComp = Cast<UHealthComponent>(pawn->GetComponentByClass(UHealthComponent::StaticClass()));
-			if(ensure(healthComp) && healthComp->GetHealth() > 0.f)
-			{
-				return;
-			}
-		}
+		return;
 	}
 
-	gameOver();
+	if(GetNumLivePlayers() <= 0)
+	{
+		gameOver();
+	}
 }
 
 void AChangingGunsGameMode::gameOver()
 {
-	endWave();
+	GetWorldTimerManager().ClearTimer(timerHandle_BotSpawner);
+	GetWorldTimerManager().ClearTimer(timerHandle_NextWaveStart);
+	GetWorldTimerManager().ClearTimer(timerHandle_StressTestWaveTimeout);
 	setWaveState(EWaveState::GameOver);
 }
 
 void AChangingGunsGameMode::setWaveState(EWaveState NewState)
 {
 	gameState->SetWaveState(NewState);
-}
\ No newline at end of file
+}
+
+void AChangingGunsGameMode::spawnStressTestBot()
+{
+	UNavigationSystemV1* navigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if(!navigationSystem)
+	{
+		return;
+	}
+
+	const APawn* player = UGameplayStatics::GetPlayerPawn(this, 0);
+	FNavLocation location;
+	if(!navigationSystem->GetRandomReachablePointInRadius(player ? player->GetActorLocation() : GetActorLocation(), stressTestSpawnRadius, location))
+	{
+		return;
+	}
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	GetWorld()->SpawnActor<AShooterTrackerBot>(stressTestBotClass ? stressTestBotClass.Get() : AShooterTrackerBot::StaticClass(), location.Location + FVector(0.f, 0.f, 50.f), FRotator::ZeroRotator, spawnParams);
+}
+
+void AChangingGunsGameMode::recordStressTestFrame()
+{
+	const double time = FPlatformTime::Seconds();
+	const double frameSeconds = time - lastStressTestFrameTime;
+	lastStressTestFrameTime = time;
+
+	//nothing is recorded before the first wave
+	if(stressTestWaveResults.Num() == 0)
+	{
+		return;
+	}
+
+	FStressTestWave& wave = stressTestWaveResults.Last();
+	wave.FrameMilliseconds.Add(frameSeconds * 1000.0);
+	wave.MaxLiveBots = FMath::Max(wave.MaxLiveBots, GetNumLiveBots(TEAMNUMBER_BOT));
+}
+
+void AChangingGunsGameMode::stressTestWaveTimedOut()
+{
+	if(stressTestWaveResults.Num() == 0)
+	{
+		return;
+	}
+
+	UE_LOG(LogTemp, Warning, TEXT("Wave stress test: wave %d timed out after %.0f s with %d bots alive"), waveCount, stressTestWaveTimeout, GetNumLiveBots(TEAMNUMBER_BOT));
+	stressTestWaveResults.Last().bTimedOut = true;
+
+	//the remaining bots would be part of the next wave, which completes as soon as they are gone
+	GetWorldTimerManager().ClearTimer(timerHandle_BotSpawner);
+	numOfBotsToSpawn = 0;
+	for(TActorIterator<AShooterTrackerBot> it(GetWorld()); it; ++it)
+	{
+		it->Destroy();
+	}
+	checkWaveState();
+}
+
+void AChangingGunsGameMode::finishStressTest()
+{
+	FGameFrameTimings::SetActive(nullptr);
+	SetActorTickEnabled(false);
+	gameOver();
+
+	const double millisecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000.0;
+	int32 degradedWave = INDEX_NONE;
+
+	TArray<TSharedPtr<FJsonValue>> jsonWaves;
+	for(int32 i = 0; i < stressTestWaveResults.Num(); ++i)
+	{
+		FStressTestWave& wave = stressTestWaveResults[i];
+		const int32 numFrames = FMath::Max(1, wave.FrameMilliseconds.Num());
+		double totalMilliseconds = 0.0;
+		for(const float frameMilliseconds : wave.FrameMilliseconds)
+		{
+			totalMilliseconds += frameMilliseconds;
+		}
+		wave.FrameMilliseconds.Sort();
+		const float p95Milliseconds = wave.FrameMilliseconds.Num() > 0 ? wave.FrameMilliseconds[FMath::Clamp(FMath::CeilToInt(0.95f * wave.FrameMilliseconds.Num()) - 1, 0, wave.FrameMilliseconds.Num() - 1)] : 0.f;
+		const float maxMilliseconds = wave.FrameMilliseconds.Num() > 0 ? wave.FrameMilliseconds.Last() : 0.f;
+		auto millisecondsPerFrame = [&](EGameFrameTiming Timing) { return wave.Timings.Cycles[static_cast<int32>(Timing)] * millisecondsPerCycle / numFrames; };
+
+		if(degradedWave == INDEX_NONE && (p95Milliseconds > stressTestFrameBudgetMs || wave.bTimedOut))
+		{
+			degradedWave = i + 1;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Wave stress test, wave %d (%d bots, max %d alive, %d frames%s): %.2f ms/frame, p95 %.2f ms, max %.2f ms, bot tick %.3f ms, pathfinding %.3f ms, overlaps %.3f ms, game mode %.3f ms"),
+			i + 1, wave.NumBots, wave.MaxLiveBots, wave.FrameMilliseconds.Num(), wave.bTimedOut ? TEXT(", timed out") : TEXT(""), totalMilliseconds / numFrames, p95Milliseconds, maxMilliseconds,
+			millisecondsPerFrame(EGameFrameTiming::BotTick), millisecondsPerFrame(EGameFrameTiming::Pathfinding), millisecondsPerFrame(EGameFrameTiming::Overlaps), millisecondsPerFrame(EGameFrameTiming::GameMode));
+
+		TSharedRef<FJsonObject> jsonWave = MakeShared<FJsonObject>();
+		jsonWave->SetNumberField(TEXT("wave"), i + 1);
+		jsonWave->SetNumberField(TEXT("bots"), wave.NumBots);
+		jsonWave->SetNumberField(TEXT("maxLiveBots"), wave.MaxLiveBots);
+		jsonWave->SetNumberField(TEXT("frames"), wave.FrameMilliseconds.Num());
+		jsonWave->SetBoolField(TEXT("timedOut"), wave.bTimedOut);
+		jsonWave->SetNumberField(TEXT("frameMs"), totalMilliseconds / numFrames);
+		jsonWave->SetNumberField(TEXT("p95FrameMs"), p95Milliseconds);
+		jsonWave->SetNumberField(TEXT("maxFrameMs"), maxMilliseconds);
+		jsonWave->SetNumberField(TEXT("botTickMsPerFrame"), millisecondsPerFrame(EGameFrameTiming::BotTick));
+		jsonWave->SetNumberField(TEXT("pathfindingMsPerFrame"), millisecondsPerFrame(EGameFrameTiming::Pathfinding));
+		jsonWave->SetNumberField(TEXT("overlapsMsPerFrame"), millisecondsPerFrame(EGameFrameTiming::Overlaps));
+		jsonWave->SetNumberField(TEXT("gameModeMsPerFrame"), millisecondsPerFrame(EGameFrameTiming::GameMode));
+		jsonWaves.Add(MakeShared<FJsonValueObject>(jsonWave));
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Wave stress test finished, first wave above %.2f ms (p95) or timed out: %d"), stressTestFrameBudgetMs, degradedWave);
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetStringField(TEXT("benchmark"), TEXT("WaveStressTest"));
+	json->SetStringField(TEXT("label"), stressTestLabel);
+	json->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	json->SetStringField(TEXT("map"), GetWorld()->GetMapName());
+	json->SetNumberField(TEXT("botsPerWaveMultiplier"), botsPerWaveMultiplier);
+	json->SetNumberField(TEXT("botSpawnInterval"), botSpawnInterval);
+	json->SetNumberField(TEXT("frameBudgetMs"), stressTestFrameBudgetMs);
+	json->SetNumberField(TEXT("waveTimeout"), stressTestWaveTimeout);
+	json->SetNumberField(TEXT("firstDegradedWave"), degradedWave);
+	json->SetArrayField(TEXT("waves"), jsonWaves);
+
+	FString jsonString;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&jsonString);
+	FJsonSerializer::Serialize(json, writer);
+	const FString outputFile = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("WaveStressTest.json");
+	if(!FFileHelper::SaveStringToFile(jsonString, *outputFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Wave stress test: couldn't write %s"), *outputFile);
+	}
+
+	stressTestWaves = 0;
+	stressTestWaveResults.Reset();
+
+	//e.g., on a build machine with -unattended
+	if(FApp::IsUnattended())
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
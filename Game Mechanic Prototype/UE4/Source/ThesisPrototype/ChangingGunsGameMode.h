@@ -4,9 +4,12 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "ChangingGuns.h"
 #include "ChangingGunsGameMode.generated.h"
 
 class AChangingGunsGameState;
+class UHealthComponent;
+class AShooterTrackerBot;
 enum class EWaveState : uint8;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnActorKilledEvent, AActor*, VictimActor, AActor*, KillerActor, AController*, KillerController);
@@ -27,10 +30,44 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Game Mode")
 	int32 botsPerWaveMultiplier;
 
+	//seconds between two spawned bots of a wave
+	UPROPERTY(EditDefaultsOnly, Category = "Game Mode", meta = (ClampMin = 0.01))
+	float botSpawnInterval = 1.f;
+
+	//the stress test spawns these bots itself instead of calling spawnNewBot
+	UPROPERTY(EditDefaultsOnly, Category = "Game Mode|Stress Test")
+	TSubclassOf<AShooterTrackerBot> stressTestBotClass;
+
+	//the bots are spawned at a random reachable point within this radius around the first player
+	UPROPERTY(EditDefaultsOnly, Category = "Game Mode|Stress Test", meta = (ClampMin = 0.0))
+	float stressTestSpawnRadius = 30.f * PROJECT_MEASURING_UNIT_FACTOR_TO_M;
+
+	//the first wave with a 95th percentile frame time above this budget is reported as the one where the game degrades
+	UPROPERTY(EditDefaultsOnly, Category = "Game Mode|Stress Test", meta = (ClampMin = 0.0))
+	float stressTestFrameBudgetMs = 1000.f / 30.f;
+
+	//a wave which isn't cleared within this many seconds is reported as degraded, its bots are removed and the next wave starts. 0 waits forever
+	UPROPERTY(EditDefaultsOnly, Category = "Game Mode|Stress Test", meta = (ClampMin = 0.0))
+	float stressTestWaveTimeout = 120.f;
+
 public:
 	AChangingGunsGameMode();
+	//reads the stress test options, e.g., MapName?StressTestWaves=20?BotsPerWaveMultiplier=5?BotSpawnInterval=0.1?StressTestWaveTimeout=120?StressTestLabel=<commit>
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
 	virtual void StartPlay() override;
+	//only ticks to record the frames of the stress test
 	virtual void Tick(float DeltaSeconds) override;
+	virtual void SetPlayerDefaults(APawn* PlayerPawn) override;
+
+	//keep the live bot and player counters up to date, called by the health components when they begin or end play or change their damage handling
+	void UpdateLiveActor(const UHealthComponent* HealthComponent);
+	void RemoveLiveActor(const UHealthComponent* HealthComponent);
+
+	//called by the game state, e.g., if a blueprint starts the boss fight
+	void HandleWaveStateChanged(EWaveState NewState, EWaveState OldState);
+
+	int32 GetNumLiveBots(uint8 TeamNumber) const;
+	int32 GetNumLivePlayers() const;
 
 protected:
 	//hook for BP to spawn a single bot
@@ -48,6 +85,16 @@ protected:
 	void gameOver();
 	void setWaveState(EWaveState NewState);
 
+	void spawnStressTestBot();
+	void recordStressTestFrame();
+	void stressTestWaveTimedOut();
+	//logs the results of every wave, writes them to Saved/Benchmarks/WaveStressTest.json and quits if the game runs unattended
+	void finishStressTest();
+	FORCEINLINE bool isStressTestRunning() const { return stressTestWaves > 0; }
+
+	UFUNCTION()
+	void onActorKilled(AActor* VictimActor, AActor* KillerActor, AController* KillerController);
+
 public:
 	UPROPERTY(BlueprintAssignable, Category = "Game Mode")
 	FOnActorKilledEvent OnActorKilledEvent;
@@ -58,4 +105,42 @@ protected:
 	int32 waveCount;
 	FTimerHandle timerHandle_NextWaveStart;
 	FTimerHandle timerHandle_BotSpawner;
+	FTimerHandle timerHandle_StressTestWaveTimeout;
+
+	enum class ELiveActorType : uint8
+	{
+		None,
+		Bot,
+		Player
+	};
+
+	struct FLiveActor
+	{
+		ELiveActorType Type;
+		uint8 TeamNumber;
+	};
+
+	ELiveActorType determineLiveActorType(const UHealthComponent* HealthComponent) const;
+	void changeLiveCounter(const FLiveActor& LiveActor, int32 Delta);
+
+	//every living bot and player by its health component, the pointers are only used as keys
+	TMap<const UHealthComponent*, FLiveActor> liveActors;
+	TMap<uint8, int32> liveBotsPerTeam;
+	TMap<uint8, int32> livePlayersPerTeam;
+
+	//from the start of a wave until the start of the next one
+	struct FStressTestWave
+	{
+		int32 NumBots = 0;
+		int32 MaxLiveBots = 0;
+		bool bTimedOut = false;
+		TArray<float> FrameMilliseconds;
+		FGameFrameTimings Timings;
+	};
+
+	//waves of the stress test, 0 if it isn't running
+	int32 stressTestWaves = 0;
+	FString stressTestLabel;
+	TArray<FStressTestWave> stressTestWaveResults;
+	double lastStressTestFrameTime = 0.0;
 };
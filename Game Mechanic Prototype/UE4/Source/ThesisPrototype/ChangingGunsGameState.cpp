@@ -2,10 +2,41 @@
 
 #include "ChangingGunsGameState.h"
 #include "UnrealNetwork.h"
+#include "ChangingGunsGameMode.h"
+#include "Engine/World.h"
+#include "Components/HealthComponent.h"
 
 void AChangingGunsGameState::SetWaveState(EWaveState NewState)
 {
 	const EWaveState oldState = waveState;
 	waveState = NewState;
 	waveStateChanged(waveState, oldState);
+
+	if (AChangingGunsGameMode* gm = GetWorld()->GetAuthGameMode<AChangingGunsGameMode>())
+	{
+		gm->HandleWaveStateChanged(waveState, oldState);
+	}
+}
+
+void AChangingGunsGameState::RegisterHealthComponent(UHealthComponent* HealthComponent)
+{
+	if (HealthComponent && HealthComponent->GetOwner())
+	{
+		healthComponents.Add(TWeakObjectPtr<const AActor>(HealthComponent->GetOwner()), HealthComponent);
+	}
+}
+
+void AChangingGunsGameState::UnregisterHealthComponent(UHealthComponent* HealthComponent)
+{
+	const AActor* owner = HealthComponent ? HealthComponent->GetOwner() : nullptr;
+	if (owner && FindHealthComponent(owner) == HealthComponent)
+	{
+		healthComponents.Remove(TWeakObjectPtr<const AActor>(owner));
+	}
+}
+
+UHealthComponent* AChangingGunsGameState::FindHealthComponent(const AActor* Actor) const
+{
+	const TWeakObjectPtr<UHealthComponent>* healthComp = healthComponents.Find(TWeakObjectPtr<const AActor>(Actor));
+	return healthComp ? healthComp->Get() : nullptr;
 }
@@ -6,6 +6,8 @@
 #include "GameFramework/GameStateBase.h"
 #include "ChangingGunsGameState.generated.h"
 
+class UHealthComponent;
+
 UENUM(BlueprintType)
 enum class EWaveState : uint8
 {
@@ -40,7 +42,16 @@ public:
 
 	FORCEINLINE EWaveState GetWaveState() const { return waveState; }
 
+	//maintained by the health components in BeginPlay and EndPlay, see UHealthComponent::FindHealthComponent
+	void RegisterHealthComponent(UHealthComponent* HealthComponent);
+	void UnregisterHealthComponent(UHealthComponent* HealthComponent);
+	UHealthComponent* FindHealthComponent(const AActor* Actor) const;
+
 protected:
 	UFUNCTION(BlueprintImplementableEvent, Category = "Game State")
 	void waveStateChanged(EWaveState NewState, EWaveState OldState);
+
+protected:
+	//every health component of the world which has begun play, by its owner
+	TMap<TWeakObjectPtr<const AActor>, TWeakObjectPtr<UHealthComponent>> healthComponents;
 };
@@ -0,0 +1,152 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "WeaponBenchmarkCommandlet.h"
+#include "Weapons/WeaponBenchmark.h"
+#include "Weapons/ShooterWeapon.h"
+#include "Pawns/ShooterCharacter.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ChangingGunsGameState.h"
+#include "ChangingGuns.h"
+
+UWeaponBenchmarkCommandlet::UWeaponBenchmarkCommandlet()
+{
+	LogToConsole = true;
+}
+
+int32 UWeaponBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 framesPerSecond = 60;
+	FString weaponClassPaths;
+	FString shooterClassPath;
+	FString label;
+	FString outputFile = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("Weapons.json");
+	FParse::Value(*Params, TEXT("Frames="), numFrames);
+	FParse::Value(*Params, TEXT("FPS="), framesPerSecond);
+	FParse::Value(*Params, TEXT("ShootersPerWeapon="), shootersPerWeaponClass);
+	FParse::Value(*Params, TEXT("TargetsY="), targetGridSize.X);
+	FParse::Value(*Params, TEXT("TargetsZ="), targetGridSize.Y);
+	FParse::Value(*Params, TEXT("Seed="), seed);
+	FParse::Value(*Params, TEXT("Weapons="), weaponClassPaths);
+	FParse::Value(*Params, TEXT("Shooter="), shooterClassPath);
+	FParse::Value(*Params, TEXT("Label="), label);
+	FParse::Value(*Params, TEXT("Output="), outputFile);
+	const bool bPlayEffects = !FParse::Param(*Params, TEXT("NoEffects"));
+	numFrames = FMath::Max(1, numFrames);
+	deltaTime = 1.f / FMath::Max(1, framesPerSecond);
+	shootersPerWeaponClass = FMath::Max(1, shootersPerWeaponClass);
+
+	TArray<FString> weaponClassPathArray;
+	weaponClassPaths.ParseIntoArray(weaponClassPathArray, TEXT("+"));
+	for (const FString& weaponClassPath : weaponClassPathArray)
+	{
+		UClass* weaponClass = LoadClass<AShooterWeapon>(nullptr, *weaponClassPath);
+		if (!weaponClass)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Weapon benchmark: couldn't load the weapon class %s"), *weaponClassPath);
+			return 1;
+		}
+		weaponClasses.Add(weaponClass);
+	}
+
+	shooterClass = shooterClassPath.IsEmpty() ? AShooterCharacter::StaticClass() : LoadClass<AShooterCharacter>(nullptr, *shooterClassPath);
+	if (!shooterClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon benchmark: couldn't load the shooter class %s"), *shooterClassPath);
+		return 1;
+	}
+
+	const TSharedRef<FJsonObject> idleResults = runPass(false, false);
+	const TSharedRef<FJsonObject> noEffectsResults = runPass(true, false);
+	const TSharedPtr<FJsonObject> effectsResults = bPlayEffects ? TSharedPtr<FJsonObject>(runPass(true, true)) : nullptr;
+
+	//everything the shooters do besides firing is in the frames of the idle pass, the damage path is timed by the targets
+	auto perItem = [](double Value, double Num) { return Num > 0.0 ? Value / Num : 0.0; };
+	const double idleFrameMs = idleResults->GetNumberField(TEXT("frameMs"));
+	const double noEffectsFrameMs = noEffectsResults->GetNumberField(TEXT("frameMs"));
+	const double fireMsPerFrame = FMath::Max(0.0, noEffectsFrameMs - idleFrameMs - noEffectsResults->GetNumberField(TEXT("damageMsPerFrame")));
+	const double fireUsPerShot = perItem(fireMsPerFrame * 1000.0 * numFrames, noEffectsResults->GetNumberField(TEXT("shots")));
+
+	TSharedRef<FJsonObject> json = effectsResults.IsValid() ? effectsResults.ToSharedRef() : noEffectsResults;
+	json->SetStringField(TEXT("benchmark"), TEXT("Weapons"));
+	json->SetStringField(TEXT("label"), label);
+	json->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	json->SetStringField(TEXT("weaponClasses"), weaponClassPaths);
+	json->SetStringField(TEXT("shooterClass"), shooterClass->GetPathName());
+	json->SetNumberField(TEXT("seed"), seed);
+	json->SetNumberField(TEXT("deltaTime"), deltaTime);
+	json->SetNumberField(TEXT("idleFrameMs"), idleFrameMs);
+	json->SetNumberField(TEXT("fireUsPerShot"), fireUsPerShot);
+	if (effectsResults.IsValid())
+	{
+		//the same seed fires the same shots in both passes
+		const double effectsMsPerFrame = FMath::Max(0.0, effectsResults->GetNumberField(TEXT("frameMs")) - noEffectsFrameMs);
+		json->SetNumberField(TEXT("effectsUsPerTrace"), perItem(effectsMsPerFrame * 1000.0 * numFrames, effectsResults->GetNumberField(TEXT("traces"))));
+		json->SetObjectField(TEXT("noEffects"), noEffectsResults);
+	}
+	UE_LOG(LogTemp, Display, TEXT("Weapon benchmark: idle %.2f ms/frame, fire %.2f us/shot, effects %.2f us/trace"),
+		idleFrameMs, fireUsPerShot, json->HasField(TEXT("effectsUsPerTrace")) ? json->GetNumberField(TEXT("effectsUsPerTrace")) : 0.0);
+
+	FString jsonString;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&jsonString);
+	FJsonSerializer::Serialize(json, writer);
+	if (!FFileHelper::SaveStringToFile(jsonString, *outputFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon benchmark: couldn't write %s"), *outputFile);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Weapon benchmark results: %s"), *outputFile);
+
+	return json->GetNumberField(TEXT("shots")) > 0.0 ? 0 : 1;
+}
+
+TSharedRef<FJsonObject> UWeaponBenchmarkCommandlet::runPass(bool bFireWeapons, bool bPlayEffects)
+{
+	//the same seed produces the same bullet spread in every pass
+	IConsoleManager::Get().FindConsoleVariable(TEXT("Game.SessionSeed"))->Set(seed, ECVF_SetByCommandline);
+	FSessionSeed::Reset();
+	//like the seed, so neither an ini file nor the command line overrides the effects of the pass
+	IConsoleManager::Get().FindConsoleVariable(TEXT("Game.WeaponEffects"))->Set(bPlayEffects ? 1 : 0, ECVF_SetByCommandline);
+
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("WeaponBenchmark"));
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+	//there is no game mode, but the game state keeps the health components, so the damage path looks them up like in the game
+	world->SetGameState(world->SpawnActor<AChangingGunsGameState>());
+	world->InitializeActorsForPlay(FURL());
+	//there is no game mode which would start the play
+	world->GetWorldSettings()->NotifyBeginPlay();
+
+	AWeaponBenchmark* benchmark = world->SpawnActorDeferred<AWeaponBenchmark>(AWeaponBenchmark::StaticClass(), FTransform::Identity);
+	benchmark->weaponClasses = weaponClasses;
+	benchmark->shooterClass = shooterClass;
+	benchmark->shootersPerWeaponClass = shootersPerWeaponClass;
+	benchmark->targetGridSize = targetGridSize;
+	benchmark->bFireWeapons = bFireWeapons;
+	benchmark->bPlayEffects = bPlayEffects;
+	//stopped after the last frame
+	benchmark->duration = 0.f;
+	benchmark->FinishSpawning(FTransform::Identity);
+
+	for (int32 frame = 0; frame < numFrames; ++frame)
+	{
+		world->Tick(LEVELTICK_All, deltaTime);
+		++GFrameCounter;
+	}
+
+	benchmark->stopBenchmark();
+	benchmark->LogResults();
+	TSharedRef<FJsonObject> results = benchmark->GetResults();
+
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+	return results;
+}
@@ -0,0 +1,48 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "WeaponBenchmarkCommandlet.generated.h"
+
+class AShooterWeapon;
+class AShooterCharacter;
+class FJsonObject;
+
+/**
+ * Runs AWeaponBenchmark for a fixed number of frames with a fixed delta time in temporary worlds, e.g., on a build machine with -nullrhi.
+ * It runs a pass in which the shooters hold their fire, one without effects and, unless -NoEffects, one with effects, all with the same seed.
+ * The differences of their frame times give the cost of fire per shot and of the effects per trace.
+ * The results are logged and written as json, e.g., to track regressions per commit. Returns 1 if no shot was fired.
+ *
+ * UE4Editor-Cmd ThesisPrototype.uproject -run=WeaponBenchmark -nullrhi -Weapons=/Game/Blueprints/Weapons/BP_Pistol.BP_Pistol_C+/Game/Blueprints/Weapons/BP_Shotgun.BP_Shotgun_C
+ *	-Frames=3600 -FPS=60 -ShootersPerWeapon=4 -TargetsY=8 -TargetsZ=8 -NoEffects -Seed=1337 -Label=<commit> -Output=<file>.json
+ */
+UCLASS()
+class UWeaponBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UWeaponBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	//runs the benchmark in a new world, the shooters hold their fire without bFireWeapons
+	TSharedRef<FJsonObject> runPass(bool bFireWeapons, bool bPlayEffects);
+
+protected:
+	UPROPERTY(Transient)
+	TArray<TSubclassOf<AShooterWeapon>> weaponClasses;
+
+	UPROPERTY(Transient)
+	TSubclassOf<AShooterCharacter> shooterClass;
+
+	int32 numFrames = 3600;
+	float deltaTime = 1.f / 60.f;
+	int32 shootersPerWeaponClass = 4;
+	FIntPoint targetGridSize = FIntPoint(8, 8);
+	int32 seed = 1337;
+};
@@ -0,0 +1,253 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "WeaponGeneratorBenchmarkCommandlet.h"
+#include "Weapons/WeaponGenerator.h"
+#include "Weapons/ShooterWeapon.h"
+#include "Weapons/ShooterWeaponPool.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "GameFramework/WorldSettings.h"
+#include "UObject/UnrealType.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/DateTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ChangingGuns.h"
+
+static uint64 GetNumMallocCalls()
+{
+#if UE_BUILD_SHIPPING
+	return 0;
+#else
+	return static_cast<uint64>(FMalloc::TotalMallocCalls);
+#endif
+}
+
+UWeaponGeneratorBenchmarkCommandlet::UWeaponGeneratorBenchmarkCommandlet()
+{
+	LogToConsole = true;
+}
+
+int32 UWeaponGeneratorBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 numCycles = 10000;
+	int32 numWarmupCycles = 100;
+	int32 seed = 1337;
+	FString dataFiles = TEXT("Scripts/training_data.csv+Scripts/test_data.csv");
+	FString generatorClassPath;
+	FString modelFile;
+	FString label;
+	FString outputFile = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("WeaponGenerator.json");
+	FParse::Value(*Params, TEXT("Cycles="), numCycles);
+	FParse::Value(*Params, TEXT("Warmup="), numWarmupCycles);
+	FParse::Value(*Params, TEXT("Seed="), seed);
+	FParse::Value(*Params, TEXT("Data="), dataFiles);
+	FParse::Value(*Params, TEXT("Generator="), generatorClassPath);
+	FParse::Value(*Params, TEXT("Model="), modelFile);
+	FParse::Value(*Params, TEXT("Label="), label);
+	FParse::Value(*Params, TEXT("Output="), outputFile);
+	numCycles = FMath::Max(1, numCycles);
+	numWarmupCycles = FMath::Max(0, numWarmupCycles);
+
+	TArray<FString> dataFilePaths;
+	dataFiles.ParseIntoArray(dataFilePaths, TEXT("+"));
+	TArray<FWeaponFeatureVector> weapons;
+	for (const FString& dataFilePath : dataFilePaths)
+	{
+		if (!loadWeaponsFromCsv(FPaths::IsRelative(dataFilePath) ? FPaths::ProjectContentDir() / dataFilePath : dataFilePath, weapons))
+			return 1;
+	}
+	if (weapons.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon generator benchmark: no weapons in %s"), *dataFiles);
+		return 1;
+	}
+
+	UClass* generatorClass = generatorClassPath.IsEmpty() ? AWeaponGenerator::StaticClass() : LoadClass<AWeaponGenerator>(nullptr, *generatorClassPath);
+	if (!generatorClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon generator benchmark: couldn't load the generator class %s"), *generatorClassPath);
+		return 1;
+	}
+
+	//every request has to be finished within DismantleWeapon and the same seed has to produce the same weapons
+	IConsoleManager::Get().FindConsoleVariable(TEXT("Game.DeterministicSimulation"))->Set(1, ECVF_SetByCommandline);
+	IConsoleManager::Get().FindConsoleVariable(TEXT("Game.SessionSeed"))->Set(seed, ECVF_SetByCommandline);
+	FSessionSeed::Reset();
+
+	UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("WeaponGeneratorBenchmark"));
+	FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	worldContext.SetCurrentWorld(world);
+	world->InitializeActorsForPlay(FURL());
+	//there is no game mode which would start the play
+	world->GetWorldSettings()->NotifyBeginPlay();
+
+	AWeaponGenerator* generator = world->SpawnActorDeferred<AWeaponGenerator>(generatorClass, FTransform::Identity);
+	generator->SetUseNativeInference(true);
+	if (!modelFile.IsEmpty())
+	{
+		generator->SetNativeModelFile(modelFile);
+	}
+	generator->FinishSpawning(FTransform::Identity);
+	generator->OnWeaponGenerationRequestFinishedEvent.AddDynamic(this, &UWeaponGeneratorBenchmarkCommandlet::onWeaponGenerationRequestFinished);
+
+	AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(world);
+	TArray<double> cycleSeconds;
+	cycleSeconds.Reserve(numCycles);
+	uint64 numMallocCalls = 0;
+	int32 numFailedCycles = 0;
+
+	if (!generator->IsReadyToUse())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon generator benchmark: couldn't load the native model %s"), *generator->GetNativeModelFile());
+		numFailedCycles = numCycles;
+	}
+
+	for (int32 cycle = -numWarmupCycles; cycle < numCycles && generator->IsReadyToUse(); ++cycle)
+	{
+		//the dismantled weapon is constructed like a generated one, but that isn't part of the measurement
+		AShooterWeapon* dismantledWeapon = generator->ConstructWeaponFromFeatures(weapons[(cycle + numWarmupCycles) % weapons.Num()]);
+		if (!dismantledWeapon)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Weapon generator benchmark: couldn't construct a weapon, are the weapon classes of %s set?"), *generatorClass->GetName());
+			numFailedCycles = numCycles;
+			break;
+		}
+
+		generatedWeapon = nullptr;
+		finishedRequestId = INDEX_NONE;
+		const uint64 mallocCallsBefore = GetNumMallocCalls();
+		const double startTime = FPlatformTime::Seconds();
+
+		//dismantle, generate and construct
+		const int32 requestId = generator->DismantleWeapon(dismantledWeapon);
+
+		const double seconds = FPlatformTime::Seconds() - startTime;
+		const uint64 mallocCalls = GetNumMallocCalls() - mallocCallsBefore;
+
+		if (cycle >= 0)
+		{
+			if (requestId != INDEX_NONE && finishedRequestId == requestId && generatedWeapon)
+			{
+				cycleSeconds.Add(seconds);
+				numMallocCalls += mallocCalls;
+			}
+			else
+			{
+				++numFailedCycles;
+			}
+		}
+
+		weaponPool->ReleaseWeapon(dismantledWeapon);
+		if (generatedWeapon)
+		{
+			weaponPool->ReleaseWeapon(generatedWeapon);
+			generatedWeapon = nullptr;
+		}
+	}
+
+	generator->OnWeaponGenerationRequestFinishedEvent.RemoveAll(this);
+	const FString generatorModelFile = generator->GetNativeModelFile();
+	GEngine->DestroyWorldContext(world);
+	world->DestroyWorld(false);
+
+	double totalSeconds = 0.0;
+	for (const double seconds : cycleSeconds)
+	{
+		totalSeconds += seconds;
+	}
+	cycleSeconds.Sort();
+	auto percentile = [&cycleSeconds](float Percentile)
+	{
+		return cycleSeconds.Num() > 0 ? cycleSeconds[FMath::Clamp(FMath::CeilToInt(Percentile * cycleSeconds.Num()) - 1, 0, cycleSeconds.Num() - 1)] : 0.0;
+	};
+
+	const int32 numGenerations = cycleSeconds.Num();
+	const double p50Milliseconds = percentile(0.5f) * 1000.0;
+	const double p99Milliseconds = percentile(0.99f) * 1000.0;
+	const double maxMilliseconds = numGenerations > 0 ? cycleSeconds.Last() * 1000.0 : 0.0;
+	const double meanMilliseconds = numGenerations > 0 ? totalSeconds * 1000.0 / numGenerations : 0.0;
+	const double generationsPerSecond = totalSeconds > 0.0 ? numGenerations / totalSeconds : 0.0;
+	const double mallocCallsPerGeneration = numGenerations > 0 ? static_cast<double>(numMallocCalls) / numGenerations : 0.0;
+
+	UE_LOG(LogTemp, Display, TEXT("Weapon generator benchmark (%d cycles, %d weapons, %d failed): p50 %.3f ms, p99 %.3f ms, max %.3f ms, %.1f generations/s, %.1f allocations/generation"),
+		numCycles, weapons.Num(), numFailedCycles, p50Milliseconds, p99Milliseconds, maxMilliseconds, generationsPerSecond, mallocCallsPerGeneration);
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetStringField(TEXT("benchmark"), TEXT("WeaponGenerator"));
+	json->SetStringField(TEXT("label"), label);
+	json->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	json->SetStringField(TEXT("generatorClass"), generatorClass->GetPathName());
+	json->SetStringField(TEXT("model"), generatorModelFile);
+	json->SetStringField(TEXT("data"), dataFiles);
+	json->SetNumberField(TEXT("seed"), seed);
+	json->SetNumberField(TEXT("weapons"), weapons.Num());
+	json->SetNumberField(TEXT("cycles"), numCycles);
+	json->SetNumberField(TEXT("warmupCycles"), numWarmupCycles);
+	json->SetNumberField(TEXT("failedCycles"), numFailedCycles);
+	json->SetNumberField(TEXT("p50Ms"), p50Milliseconds);
+	json->SetNumberField(TEXT("p99Ms"), p99Milliseconds);
+	json->SetNumberField(TEXT("maxMs"), maxMilliseconds);
+	json->SetNumberField(TEXT("meanMs"), meanMilliseconds);
+	json->SetNumberField(TEXT("generationsPerSecond"), generationsPerSecond);
+	json->SetNumberField(TEXT("allocationsPerGeneration"), mallocCallsPerGeneration);
+
+	FString jsonString;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&jsonString);
+	FJsonSerializer::Serialize(json, writer);
+	if (!FFileHelper::SaveStringToFile(jsonString, *outputFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon generator benchmark: couldn't write %s"), *outputFile);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Weapon generator benchmark results: %s"), *outputFile);
+
+	return numFailedCycles > 0 ? 1 : 0;
+}
+
+bool UWeaponGeneratorBenchmarkCommandlet::loadWeaponsFromCsv(const FString& FilePath, TArray<FWeaponFeatureVector>& OutWeapons)
+{
+	TArray<FString> lines;
+	if (!FFileHelper::LoadFileToStringArray(lines, *FilePath) || lines.Num() < 2)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Weapon generator benchmark: couldn't read %s"), *FilePath);
+		return false;
+	}
+
+	TArray<FString> columns;
+	lines[0].ParseIntoArray(columns, TEXT(","), false);
+
+	UScriptStruct* jsonDataStruct = FWeaponGeneratorAPIJsonData::StaticStruct();
+	for (int32 line = 1; line < lines.Num(); ++line)
+	{
+		TArray<FString> values;
+		lines[line].ParseIntoArray(values, TEXT(","), false);
+		if (values.Num() != columns.Num())
+			continue;
+
+		//the columns which aren't features are skipped, the categorical ones are one hot encoded like pandas.get_dummies does it, e.g., type MG is type_MG
+		FWeaponGeneratorAPIJsonData jsonData;
+		for (int32 column = 0; column < columns.Num(); ++column)
+		{
+			const bool bIsCategory = columns[column] == TEXT("type") || columns[column] == TEXT("firemode");
+			const FString fieldName = bIsCategory ? columns[column] + TEXT("_") + values[column] : columns[column];
+			if (UStrProperty* field = FindField<UStrProperty>(jsonDataStruct, *fieldName))
+			{
+				field->SetPropertyValue_InContainer(&jsonData, bIsCategory ? FString(TEXT("1")) : values[column]);
+			}
+		}
+		OutWeapons.Add(jsonData.ToFeatureVector());
+	}
+	return true;
+}
+
+void UWeaponGeneratorBenchmarkCommandlet::onWeaponGenerationRequestFinished(int32 RequestId, AShooterWeapon* GeneratedWeapon)
+{
+	finishedRequestId = RequestId;
+	generatedWeapon = GeneratedWeapon;
+}
@@ -0,0 +1,45 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "Weapons/WeaponFeatureVector.h"
+#include "WeaponGeneratorBenchmarkCommandlet.generated.h"
+
+class AWeaponGenerator;
+class AShooterWeapon;
+
+/**
+ * Measures the throughput of the native weapon generator without a PIE session.
+ * Every cycle constructs a weapon from a row of the training or test data, dismantles it (applySomeModifications),
+ * generates a new one with the VAE and constructs it, so it runs the same code as the game in a temporary world.
+ * The generator runs deterministically (Game.DeterministicSimulation), i.e., every request is finished within DismantleWeapon.
+ * The results are logged and written as json, e.g., to track regressions per commit.
+ *
+ * UE4Editor-Cmd ThesisPrototype.uproject -run=WeaponGeneratorBenchmark -Generator=/Game/Blueprints/BP_TensorFlowWeaponGenerator.BP_TensorFlowWeaponGenerator_C
+ *	-Cycles=10000 -Warmup=100 -Data=Scripts/training_data.csv+Scripts/test_data.csv -Model=Scripts/trained_vae/model.wvae -Seed=1337 -Label=<commit> -Output=<file>.json
+ */
+UCLASS()
+class UWeaponGeneratorBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UWeaponGeneratorBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+protected:
+	//reads the rows of a data file like the python scripts do, the columns are mapped with the fields of FWeaponGeneratorAPIJsonData
+	static bool loadWeaponsFromCsv(const FString& FilePath, TArray<FWeaponFeatureVector>& OutWeapons);
+
+	UFUNCTION()
+	void onWeaponGenerationRequestFinished(int32 RequestId, AShooterWeapon* GeneratedWeapon);
+
+protected:
+	UPROPERTY(Transient)
+	AShooterWeapon* generatedWeapon = nullptr;
+
+	int32 finishedRequestId = INDEX_NONE;
+};
@@ -4,6 +4,7 @@
 #include "GameFramework/Actor.h"
 #include "UnrealNetwork.h"
 #include "ChangingGunsGameMode.h"
+#include "ChangingGunsGameState.h"
 #include "Engine/World.h"
 #include "ChangingGuns.h"
 
@@ -15,6 +16,32 @@ FAutoConsoleVariableRef CVARDebuHealthComponents(
 	ECVF_Cheat
 );
 
+static int32 DeferHealthDamage = 1;
+FAutoConsoleVariableRef CVARDeferHealthDamage(
+	TEXT("Game.DeferHealthDamage"),
+	DeferHealthDamage,
+	TEXT("Collect the damage of a frame per health component and apply it at the end of the frame with one broadcast per event"),
+	ECVF_Default
+);
+
+//friendly teams share a group, i.e., the TEAMNUMBER_BOT_RANGE and all the others
+struct FTeamRelationTable
+{
+	static const uint8 OtherGroup = 0;
+	static const uint8 BotGroup = 1;
+
+	uint8 TeamGroups[256];
+
+	FTeamRelationTable()
+	{
+		for (int32 team = 0; team < 256; ++team)
+		{
+			TeamGroups[team] = team >= TEAMNUMBER_BOT_RANGE_MIN && team <= TEAMNUMBER_BOT_RANGE_MAX ? BotGroup : OtherGroup;
+		}
+	}
+};
+static const FTeamRelationTable TeamRelations;
+
 UHealthComponent::UHealthComponent()
 {
 	defaultHealth = 100;
@@ -22,6 +49,10 @@ UHealthComponent::UHealthComponent()
 	defaultArmor = 0;
 	defaultExtraLives = 0;
 	bHandleDamageEnabled = true;
+
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
 }
 
 void UHealthComponent::Heal(float HealAmount)
@@ -67,11 +98,13 @@ void UHealthComponent::RestoreExtraLife(int32 Lives)
 void UHealthComponent::SetHandleDamageEnabled(bool HandleDamage)
 {
 	bHandleDamageEnabled = HandleDamage;
+	updateGameModeLiveActors();
 }
 
 void UHealthComponent::SetTeamNumber(uint8 TeamNumber)
 {
 	teamNumber = TeamNumber;
+	updateGameModeLiveActors();
 }
 
 void UHealthComponent::BeginPlay()
@@ -82,10 +115,60 @@ void UHealthComponent::BeginPlay()
 	if (AActor* owner = GetOwner())
 	{
 		owner->OnTakeAnyDamage.AddDynamic(this, &UHealthComponent::handleTakeAnyDamage);
+		if (AChangingGunsGameState* gs = GetWorld()->GetGameState<AChangingGunsGameState>())
+		{
+			gs->RegisterHealthComponent(this);
+		}
 	}
 	health = defaultHealth;
 	armor = defaultArmor;
 	extraLives = defaultExtraLives;
+
+	updateGameModeLiveActors();
+}
+
+void UHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AChangingGunsGameState* gs = GetWorld()->GetGameState<AChangingGunsGameState>())
+	{
+		gs->UnregisterHealthComponent(this);
+	}
+
+	//on level transitions the game mode is torn down as well
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		if (AChangingGunsGameMode* gm = Cast<AChangingGunsGameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			gm->RemoveLiveActor(this);
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHealthComponent::updateGameModeLiveActors()
+{
+	if (!HasBegunPlay())
+	{
+		return;
+	}
+
+	if (AChangingGunsGameMode* gm = Cast<AChangingGunsGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		gm->UpdateLiveActor(this);
+	}
+}
+
+void UHealthComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//the broadcasts can cause new damage, e.g., exploding barrels
+	const FPendingDamages damages = MoveTemp(pendingDamages);
+	pendingDamages.Reset();
+	SetComponentTickEnabled(false);
+
+	applyDamages(damages);
 }
 
 void UHealthComponent::handleTakeAnyDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
@@ -100,6 +183,86 @@ void UHealthComponent::handleTakeAnyDamage(AActor* DamagedActor, float Damage, c
 		return;
 	}
 
+	FPendingDamages damages;
+	FPendingDamages& targetDamages = DeferHealthDamage > 0 ? pendingDamages : damages;
+	FPendingDamage& pendingDamage = targetDamages[targetDamages.AddUninitialized()];
+	pendingDamage.Damage = Damage;
+	pendingDamage.DamageType = DamageType;
+	pendingDamage.InstigatedBy = InstigatedBy;
+	pendingDamage.DamageCauser = DamageCauser;
+
+	if(DeferHealthDamage > 0)
+	{
+		SetComponentTickEnabled(true);
+		return;
+	}
+	applyDamages(damages);
+}
+
+void UHealthComponent::applyDamages(const FPendingDamages& Damages)
+{
+	float armorDelta = 0.f;
+	float healthDelta = 0.f;
+	bool bArmorChanged = false;
+	bool bExtraLivesChanged = false;
+	const FPendingDamage* lastHealthDamage = nullptr;
+
+	for(const FPendingDamage& damage : Damages)
+	{
+		if(bIsDead || !bHandleDamageEnabled)
+		{
+			break;
+		}
+
+		switch(applyDamage(damage.Damage))
+		{
+		case EAppliedDamage::Armor:
+			bArmorChanged = true;
+			armorDelta += damage.Damage;
+			break;
+		case EAppliedDamage::ExtraLife:
+			bExtraLivesChanged = true;
+			healthDelta += defaultHealth;
+			lastHealthDamage = &damage;
+			break;
+		case EAppliedDamage::Health:
+			healthDelta += damage.Damage;
+			lastHealthDamage = &damage;
+			break;
+		}
+	}
+
+	if(bArmorChanged)
+	{
+		OnArmorChangedEvent.Broadcast(this, armor, armorDelta, nullptr, nullptr, nullptr);
+	}
+
+	if(bExtraLivesChanged)
+	{
+		OnExtraLivesChangedEvent.Broadcast(this, extraLives);
+	}
+
+	if(!lastHealthDamage)
+	{
+		return;
+	}
+
+	//the last hit is the killing one
+	AController* instigatedBy = lastHealthDamage->InstigatedBy.Get();
+	AActor* damageCauser = lastHealthDamage->DamageCauser.Get();
+	OnHealthChangedEvent.Broadcast(this, health, healthDelta, lastHealthDamage->DamageType, instigatedBy, damageCauser);
+
+	if(bIsDead)
+	{
+		if (AChangingGunsGameMode* gm = Cast<AChangingGunsGameMode>(GetOwner()->GetWorld()->GetAuthGameMode()))
+		{
+			gm->OnActorKilledEvent.Broadcast(GetOwner(), damageCauser, instigatedBy);
+		}
+	}
+}
+
+UHealthComponent::EAppliedDamage UHealthComponent::applyDamage(float Damage)
+{
 	if(armor > 0.f)
 	{
 		armor = FMath::Clamp(armor - Damage, 0.f, defaultArmor);
@@ -107,8 +270,7 @@ void UHealthComponent::handleTakeAnyDamage(AActor* DamagedActor, float Damage, c
 		{
 			UE_LOG(LogTemp, Log, TEXT("%s - Armor changed to %s (-%s)"), *GetOwner()->GetName(), *FString::SanitizeFloat(armor), *FString::SanitizeFloat(Damage));
 		}
-		OnArmorChangedEvent.Broadcast(this, armor, Damage, nullptr, nullptr, nullptr);
-		return;
+		return EAppliedDamage::Armor;
 	}
 	health = FMath::Clamp(health - Damage, 0.f, defaultHealth);
 
@@ -119,14 +281,12 @@ void UHealthComponent::handleTakeAnyDamage(AActor* DamagedActor, float Damage, c
 		{
 			UE_LOG(LogTemp, Log, TEXT("%s - Lifes changed to %s (-%s)"), *GetOwner()->GetName(), *FString::SanitizeFloat(extraLives), *FString::SanitizeFloat(-1));
 		}
-		OnExtraLivesChangedEvent.Broadcast(this, extraLives);
 		health = defaultHealth;
-		OnHealthChangedEvent.Broadcast(this, health, defaultHealth, DamageType, InstigatedBy, DamageCauser);
 		if (DebugHealthComponents > 0 && GetOwner())
 		{
 			UE_LOG(LogTemp, Log, TEXT("%s - Health changed to %s (-%s)"), *GetOwner()->GetName(), *FString::SanitizeFloat(health), *FString::SanitizeFloat(defaultHealth));
 		}
-		return;
+		return EAppliedDamage::ExtraLife;
 	}
 	bIsDead = health <= 0.f;
 
@@ -134,50 +294,59 @@ void UHealthComponent::handleTakeAnyDamage(AActor* DamagedActor, float Damage, c
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s - Health changed to %s (-%s)"), *GetOwner()->GetName(), *FString::SanitizeFloat(health), *FString::SanitizeFloat(Damage));
 	}
-
-	OnHealthChangedEvent.Broadcast(this, health, Damage, DamageType, InstigatedBy, DamageCauser);
-
-	if(bIsDead)
-	{
-		if (AChangingGunsGameMode* gm = Cast<AChangingGunsGameMode>(GetOwner()->GetWorld()->GetAuthGameMode()))
-		{
-			gm->OnActorKilledEvent.Broadcast(GetOwner(), DamageCauser, InstigatedBy);
-		}
-	}
+	return EAppliedDamage::Health;
 }
 
 bool UHealthComponent::IsFriendly(AActor* ActorA, AActor* ActorB)
 {
-	if (!ActorA || !ActorB)
-	{
-		return true;
-	}
-
-	UHealthComponent* healthCompA = Cast<UHealthComponent>(ActorA->GetComponentByClass(StaticClass()));
-	UHealthComponent* healthCompB = Cast<UHealthComponent>(ActorB->GetComponentByClass(StaticClass()));
+	const UHealthComponent* healthCompA = FindHealthComponent(ActorA);
+	const UHealthComponent* healthCompB = FindHealthComponent(ActorB);
 
 	if(!healthCompA || !healthCompB)
 	{
 		return true;
 	}
-	
-	return healthCompA->teamNumber == healthCompB->teamNumber || IsBot(ActorA) == IsBot(ActorB);
+
+	return AreTeamsFriendly(healthCompA->teamNumber, healthCompB->teamNumber);
 }
 
 
 bool UHealthComponent::IsBot(AActor* Actor)
 {
-	if (!Actor)
+	const UHealthComponent* healthComp = FindHealthComponent(Actor);
+
+	if (!healthComp)
 	{
 		return false;
 	}
 
-	UHealthComponent* healthComp = Cast<UHealthComponent>(Actor->GetComponentByClass(StaticClass()));
+	return IsBotTeam(healthComp->teamNumber);
+}
 
-	if (!healthComp)
+UHealthComponent* UHealthComponent::FindHealthComponent(const AActor* Actor)
+{
+	if (!Actor)
 	{
-		return false;
+		return nullptr;
 	}
 
-	return healthComp->teamNumber >= TEAMNUMBER_BOT_RANGE_MIN && healthComp->teamNumber <= TEAMNUMBER_BOT_RANGE_MAX;
-}
\ No newline at end of file
+	const UWorld* world = Actor->GetWorld();
+	if (const AChangingGunsGameState* gs = world ? world->GetGameState<AChangingGunsGameState>() : nullptr)
+	{
+		return gs->FindHealthComponent(Actor);
+	}
+
+	//worlds without the game state of the game mode have no registry
+	return Actor->FindComponentByClass<UHealthComponent>();
+}
+
+bool UHealthComponent::AreTeamsFriendly(uint8 TeamNumberA, uint8 TeamNumberB)
+{
+	//same team or both are bots or both are not
+	return TeamRelations.TeamGroups[TeamNumberA] == TeamRelations.TeamGroups[TeamNumberB];
+}
+
+bool UHealthComponent::IsBotTeam(uint8 TeamNumber)
+{
+	return TeamRelations.TeamGroups[TeamNumber] == FTeamRelationTable::BotGroup;
+}
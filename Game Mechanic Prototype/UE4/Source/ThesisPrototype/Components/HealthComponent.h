@@ -72,12 +72,45 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Health Component")
 	static bool IsBot(AActor* Actor);
 
+	//health component of the actor from the registry of the AChangingGunsGameState, which is maintained in BeginPlay and EndPlay, so no components are searched.
+	//the components are only searched in worlds without that game state
+	static UHealthComponent* FindHealthComponent(const AActor* Actor);
+
+	static bool AreTeamsFriendly(uint8 TeamNumberA, uint8 TeamNumberB);
+	static bool IsBotTeam(uint8 TeamNumber);
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	//applies the damage of this frame, see Game.DeferHealthDamage
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 	UFUNCTION()
 	void handleTakeAnyDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser);
 
+	struct FPendingDamage
+	{
+		float Damage;
+		const UDamageType* DamageType;
+		TWeakObjectPtr<AController> InstigatedBy;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+	typedef TArray<FPendingDamage, TInlineAllocator<16>> FPendingDamages;
+
+	enum class EAppliedDamage : uint8
+	{
+		Armor,
+		ExtraLife,
+		Health
+	};
+
+	//lets the game mode count this actor as live bot or player
+	void updateGameModeLiveActors();
+
+	//applies the hits one after another like they arrived but broadcasts every changed value only once
+	void applyDamages(const FPendingDamages& Damages);
+	EAppliedDamage applyDamage(float Damage);
+
 public:
 	UPROPERTY(BlueprintAssignable, Category = "Health Component")
 	FOnHealthChangedEvent OnHealthChangedEvent;
@@ -90,4 +123,7 @@ public:
 
 protected:
 	bool bIsDead = false;
+
+	//hits which are applied at the end of the frame, they passed the friendly check already
+	FPendingDamages pendingDamages;
 };
@@ -9,6 +9,7 @@
 #include "UnrealNetwork.h"
 #include "Sound/SoundCue.h"
 #include "ChangingGuns.h"
+#include "ShooterEffectPool.h"
 
 // Sets default values
 AExplosiveBarrel::AExplosiveBarrel()
@@ -49,9 +50,12 @@ void AExplosiveBarrel::onHealthChanged(const UHealthComponent* HealthComponent,
 	if(Health <= 0.f)
 	{
 		bExploded = true;
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), explosionEffect, GetActorLocation());
+		if (AShooterEffectPool* effectPool = AShooterEffectPool::Get(GetWorld()))
+		{
+			effectPool->SpawnEmitterAtLocation(explosionEffect, GetActorLocation());
+			effectPool->PlaySoundAtLocation(explosionSound, GetActorLocation());
+		}
 		meshComp->SetMaterial(0, explodeMaterial);
-		UGameplayStatics::PlaySoundAtLocation(this, explosionSound, GetActorLocation());
 
 		TArray<AActor*> ignoreDamageActors{ this };
 		UGameplayStatics::ApplyRadialDamage(GetWorld(), baseDamage, GetActorLocation(), damageRadius, damageType, ignoreDamageActors, this, GetInstigatorController(), true);
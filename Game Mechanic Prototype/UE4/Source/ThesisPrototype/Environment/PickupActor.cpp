@@ -10,8 +10,8 @@
 // Sets default values
 APickupActor::APickupActor()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	//pickups only react to overlaps and timers
+	PrimaryActorTick.bCanEverTick = false;
 
 	sphereComp = CreateDefaultSubobject<USphereComponent>(TEXT("SphereComp"));
 	sphereComp->SetSphereRadius(75.f);
@@ -48,13 +48,6 @@ void APickupActor::respawnPowerUp()
 	spawnedPowerUp = GetWorld()->SpawnActor<APowerUpActor>(powerUpClass, GetTransform(), spawnParams);
 }
 
-// Called every frame
-void APickupActor::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-}
-
 void APickupActor::NotifyActorBeginOverlap(AActor* OtherActor)
 {
 	Super::NotifyActorBeginOverlap(OtherActor);
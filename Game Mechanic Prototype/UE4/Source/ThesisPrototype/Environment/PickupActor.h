@@ -30,7 +30,6 @@ protected:
 
 public:
 	APickupActor();
-	virtual void Tick(float DeltaTime) override;
 	virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
 
 protected:
@@ -12,6 +12,7 @@
 #include "Components/HealthComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Weapons/WeaponGenerator.h"
+#include "Weapons/ShooterWeaponPool.h"
 
 // Sets default values
 AShooterCharacter::AShooterCharacter()
@@ -56,14 +57,18 @@ void AShooterCharacter::BeginPlay()
 	defaultFOV = cameraComp->FieldOfView;
 	healthComp->OnHealthChangedEvent.AddDynamic(this, &AShooterCharacter::onHealthChanged);
 
-	FActorSpawnParameters spawnParams;
-	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-	for(const TSubclassOf<AShooterWeapon> weaponClass : starterWeaponClasses)
+	if(AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(GetWorld()))
 	{
-		AShooterWeapon* starterWeapon = GetWorld()->SpawnActor<AShooterWeapon>(weaponClass, FVector::ZeroVector, FRotator::ZeroRotator, spawnParams);
-		addWeapon(starterWeapon);
+		for(const TSubclassOf<AShooterWeapon> weaponClass : starterWeaponClasses)
+		{
+			AShooterWeapon* starterWeapon = weaponPool->AcquireWeapon(weaponClass, FTransform::Identity);
+			addWeapon(starterWeapon);
+		}
 	}
 
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
 	if(bp_weaponGenerator.GetDefaultObject())
 	{
 		weaponGenerator = GetWorld()->SpawnActor<AWeaponGenerator>(bp_weaponGenerator, FVector::ZeroVector, FRotator::ZeroRotator, spawnParams);
@@ -259,16 +264,17 @@ void AShooterCharacter::removeWeapon(AShooterWeapon* Weapon)
 	if(Weapon && Weapon != equippedWeapon)
 	{
 		availableWeapons.Remove(Weapon);
-		if(!Weapon->IsPendingKill())
+		if(AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(GetWorld()))
 		{
-			Weapon->Destroy();
+			weaponPool->ReleaseWeapon(Weapon);
 		}
 	}
 }
 
 void AShooterCharacter::dismantleEquippedWeaponAndGenerateNew()
 {
-	if (weaponGenerator->IsGenerating() || !weaponGenerator->IsReadyToUse())
+	//the generator queues the requests, so there is no need to wait for the last one
+	if (!weaponGenerator || !weaponGenerator->IsReadyToUse() || !equippedWeapon)
 		return;
 
 	AShooterWeapon* dismantle = equippedWeapon;
@@ -299,13 +305,29 @@ void AShooterCharacter::onHealthChanged(const UHealthComponent* HealthComponent,
 		GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
 		DetachFromControllerPendingDestroy();
+		//the weapons go back to the weapon pool in EndPlay
 		SetLifeSpan(10.f);
+	}
+}
 
-		for(AShooterWeapon* weapon : availableWeapons)
+void AShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//on level transitions the whole world is torn down anyway
+	if(EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		if(AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(GetWorld()))
 		{
-			weapon->SetLifeSpan(10.f);
+			for(AShooterWeapon* weapon : availableWeapons)
+			{
+				weaponPool->ReleaseWeapon(weapon);
+			}
 		}
+		availableWeapons.Empty();
+		equippedWeapon = nullptr;
+		lastEquippedWeapon = nullptr;
 	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
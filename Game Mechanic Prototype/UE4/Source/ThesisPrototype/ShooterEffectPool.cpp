@@ -0,0 +1,212 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "ShooterEffectPool.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "ChangingGuns.h"
+
+AShooterEffectPool::AShooterEffectPool()
+{
+	PrimaryActorTick.bCanEverTick = false;
+}
+
+AShooterEffectPool* AShooterEffectPool::Get(UWorld* World)
+{
+	return TWorldSingleton<AShooterEffectPool>::Get(World);
+}
+
+UParticleSystemComponent* AShooterEffectPool::SpawnEmitterAtLocation(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation, float CullDistance)
+{
+	if (!Template || isCulled(Location, CullDistance))
+		return nullptr;
+
+	UParticleSystemComponent* particleSystem = acquireParticleSystem(Template);
+	particleSystem->SetWorldLocationAndRotation(Location, Rotation);
+	particleSystem->ActivateSystem(true);
+	return particleSystem;
+}
+
+UParticleSystemComponent* AShooterEffectPool::SpawnEmitterAttached(UParticleSystem* Template, USceneComponent* AttachToComponent, FName AttachPointName)
+{
+	if (!Template || !AttachToComponent)
+		return nullptr;
+
+	UParticleSystemComponent* particleSystem = acquireParticleSystem(Template);
+	particleSystem->bAutoManageAttachment = true;
+	particleSystem->SetAutoAttachmentParameters(AttachToComponent, AttachPointName, EAttachmentRule::SnapToTarget, EAttachmentRule::SnapToTarget, EAttachmentRule::KeepWorld);
+	watchAttachParent(AttachToComponent);
+	particleSystem->ActivateSystem(true);
+	return particleSystem;
+}
+
+UAudioComponent* AShooterEffectPool::PlaySoundAtLocation(USoundBase* Sound, const FVector& Location, float CullDistance, float VolumeMultiplier)
+{
+	if (!Sound || isCulled(Location, CullDistance))
+		return nullptr;
+
+	UAudioComponent* audioComponent = acquireSound(Sound);
+	audioComponent->SetWorldLocation(Location);
+	audioComponent->VolumeMultiplier = VolumeMultiplier;
+	audioComponent->Play();
+	return audioComponent;
+}
+
+UAudioComponent* AShooterEffectPool::SpawnSoundAttached(USoundBase* Sound, USceneComponent* AttachToComponent, FName AttachPointName)
+{
+	if (!Sound || !AttachToComponent)
+		return nullptr;
+
+	UAudioComponent* audioComponent = acquireSound(Sound);
+	audioComponent->bAutoManageAttachment = true;
+	audioComponent->SetAutoAttachmentParameters(AttachToComponent, AttachPointName, EAttachmentRule::SnapToTarget, EAttachmentRule::SnapToTarget, EAttachmentRule::KeepWorld);
+	watchAttachParent(AttachToComponent);
+	audioComponent->Play();
+	return audioComponent;
+}
+
+UParticleSystemComponent* AShooterEffectPool::acquireParticleSystem(UParticleSystem* Template)
+{
+	FPooledParticleSystems& pool = pooledParticleSystems.FindOrAdd(Template);
+	pool.Components.RemoveAll([](const UParticleSystemComponent* Component) { return !Component || Component->IsPendingKill(); });
+
+	UParticleSystemComponent* particleSystem = nullptr;
+	for (UParticleSystemComponent* component : pool.Components)
+	{
+		if (!component->IsActive())
+		{
+			particleSystem = component;
+			break;
+		}
+	}
+
+	if (!particleSystem && pool.Components.Num() < maxParticleSystemsPerTemplate)
+	{
+		particleSystem = NewObject<UParticleSystemComponent>(this);
+		particleSystem->bAutoActivate = false;
+		particleSystem->bAutoDestroy = false;
+		particleSystem->SecondsBeforeInactive = 0.f;
+		particleSystem->SetTemplate(Template);
+		particleSystem->RegisterComponent();
+		pool.Components.Add(particleSystem);
+	}
+
+	//over budget, the oldest effect makes room for the new one
+	if (!particleSystem)
+	{
+		pool.NextToRecycle %= pool.Components.Num();
+		particleSystem = pool.Components[pool.NextToRecycle++];
+		particleSystem->DeactivateImmediate();
+	}
+
+	//effects at a location must not attach to the parent of the previous effect
+	particleSystem->bAutoManageAttachment = false;
+	if (particleSystem->GetAttachParent())
+	{
+		particleSystem->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	}
+	return particleSystem;
+}
+
+UAudioComponent* AShooterEffectPool::acquireSound(USoundBase* Sound)
+{
+	FPooledSounds& pool = pooledSounds.FindOrAdd(Sound);
+	pool.Components.RemoveAll([](const UAudioComponent* Component) { return !Component || Component->IsPendingKill(); });
+
+	UAudioComponent* audioComponent = nullptr;
+	for (UAudioComponent* component : pool.Components)
+	{
+		if (!component->IsPlaying())
+		{
+			audioComponent = component;
+			break;
+		}
+	}
+
+	if (!audioComponent && pool.Components.Num() < maxSoundsPerTemplate)
+	{
+		audioComponent = NewObject<UAudioComponent>(this);
+		audioComponent->bAutoActivate = false;
+		audioComponent->bAutoDestroy = false;
+		audioComponent->SetSound(Sound);
+		audioComponent->RegisterComponent();
+		pool.Components.Add(audioComponent);
+	}
+
+	if (!audioComponent)
+	{
+		pool.NextToRecycle %= pool.Components.Num();
+		audioComponent = pool.Components[pool.NextToRecycle++];
+		audioComponent->Stop();
+	}
+
+	audioComponent->bAutoManageAttachment = false;
+	audioComponent->VolumeMultiplier = 1.f;
+	if (audioComponent->GetAttachParent())
+	{
+		audioComponent->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+	}
+	return audioComponent;
+}
+
+void AShooterEffectPool::StopAttachedEffects(const AActor* Actor)
+{
+	if (!Actor)
+		return;
+
+	auto isAttachedToActor = [Actor](const USceneComponent* Component) { return Component && Component->GetAttachParent() && Component->GetAttachParent()->GetOwner() == Actor; };
+	for (auto& pool : pooledParticleSystems)
+	{
+		for (UParticleSystemComponent* component : pool.Value.Components)
+		{
+			if (isAttachedToActor(component))
+			{
+				component->DeactivateImmediate();
+				component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+			}
+		}
+	}
+	for (auto& pool : pooledSounds)
+	{
+		for (UAudioComponent* component : pool.Value.Components)
+		{
+			if (isAttachedToActor(component))
+			{
+				component->Stop();
+				component->DetachFromComponent(FDetachmentTransformRules::KeepWorldTransform);
+			}
+		}
+	}
+}
+
+void AShooterEffectPool::watchAttachParent(USceneComponent* AttachToComponent)
+{
+	if (AActor* parentActor = AttachToComponent->GetOwner())
+	{
+		parentActor->OnEndPlay.AddUniqueDynamic(this, &AShooterEffectPool::onAttachParentEndPlay);
+	}
+}
+
+void AShooterEffectPool::onAttachParentEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	StopAttachedEffects(Actor);
+}
+
+bool AShooterEffectPool::isCulled(const FVector& Location, float CullDistance) const
+{
+	if (CullDistance <= 0.f)
+		return false;
+
+	const float cullDistanceSquared = FMath::Square(CullDistance);
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		const APlayerController* pc = it->Get();
+		if (pc && pc->IsLocalController() && pc->PlayerCameraManager && FVector::DistSquared(pc->PlayerCameraManager->GetCameraLocation(), Location) <= cullDistanceSquared)
+			return false;
+	}
+	return true;
+}
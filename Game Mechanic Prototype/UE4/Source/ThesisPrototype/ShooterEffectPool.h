@@ -0,0 +1,89 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ShooterEffectPool.generated.h"
+
+class UParticleSystem;
+class UParticleSystemComponent;
+class USoundBase;
+class UAudioComponent;
+
+USTRUCT()
+struct FPooledParticleSystems
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UParticleSystemComponent*> Components;
+
+	//oldest component which is taken over if all of them are active
+	int32 NextToRecycle = 0;
+};
+
+USTRUCT()
+struct FPooledSounds
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UAudioComponent*> Components;
+
+	int32 NextToRecycle = 0;
+};
+
+/**
+ * Keeps particle system and audio components per template and plays the effects of weapons and explosions with them
+ * instead of creating a new component for every shot, pellet and impact.
+ * Every template has a budget of components, when all of them are busy the oldest one is restarted for the new effect.
+ * Attached effects are attached only while they play and stopped when their parent actor ends play.
+ * Effects with a cull distance are skipped if no local player is that close.
+ */
+UCLASS(NotBlueprintable)
+class THESISPROTOTYPE_API AShooterEffectPool : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AShooterEffectPool();
+
+	//see TWorldSingleton
+	static AShooterEffectPool* Get(UWorld* World);
+
+	//the returned component belongs to the pool and is reused as soon as it finished, nullptr if the effect is culled
+	UParticleSystemComponent* SpawnEmitterAtLocation(UParticleSystem* Template, const FVector& Location, const FRotator& Rotation = FRotator::ZeroRotator, float CullDistance = 0.f);
+	UParticleSystemComponent* SpawnEmitterAttached(UParticleSystem* Template, USceneComponent* AttachToComponent, FName AttachPointName = NAME_None);
+
+	UAudioComponent* PlaySoundAtLocation(USoundBase* Sound, const FVector& Location, float CullDistance = 0.f, float VolumeMultiplier = 1.f);
+	UAudioComponent* SpawnSoundAttached(USoundBase* Sound, USceneComponent* AttachToComponent, FName AttachPointName = NAME_None);
+
+	//stops and detaches the effects which are attached to the actor, e.g., when a pooled weapon is hidden. called when the actor ends play
+	void StopAttachedEffects(const AActor* Actor);
+
+protected:
+	//the attached effects detach themselves when they finish, otherwise when their parent ends play
+	void watchAttachParent(USceneComponent* AttachToComponent);
+
+	UFUNCTION()
+	void onAttachParentEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	UParticleSystemComponent* acquireParticleSystem(UParticleSystem* Template);
+	UAudioComponent* acquireSound(USoundBase* Sound);
+	//true if the location is farther away than CullDistance from every local player
+	bool isCulled(const FVector& Location, float CullDistance) const;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category = "Effect Pool", meta = (ClampMin = 1))
+	int32 maxParticleSystemsPerTemplate = 32;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Effect Pool", meta = (ClampMin = 1))
+	int32 maxSoundsPerTemplate = 16;
+
+	UPROPERTY(Transient)
+	TMap<UParticleSystem*, FPooledParticleSystems> pooledParticleSystems;
+
+	UPROPERTY(Transient)
+	TMap<USoundBase*, FPooledSounds> pooledSounds;
+};
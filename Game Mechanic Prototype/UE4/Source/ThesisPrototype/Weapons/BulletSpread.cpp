@@ -0,0 +1,143 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "BulletSpread.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+void FWeaponRandomStream::FillFractions(float* OutFractions, int32 Num)
+{
+	for (int32 i = 0; i < Num; ++i)
+	{
+		OutFractions[i] = toFraction(hash(seed, counter + i));
+	}
+	counter += Num;
+}
+
+void FBulletSpread::CalculateDirections(FWeaponRandomStream& RandomStream, const FVector& Direction, float RandomPower, float MinSpread, float MaxSpread, float Modifier, FVector* OutDirections, int32 Num)
+{
+	//OutDirections may contain Direction
+	const FVector baseDirection = Direction;
+
+	//pellets are processed in chunks so the intermediate arrays stay on the stack
+	const int32 chunkSize = 64;
+	float spreads[chunkSize];
+	float powers[chunkSize];
+	float angles[chunkSize];
+	float dispersionsX[chunkSize];
+	float dispersionsY[chunkSize];
+
+	for (int32 chunkStart = 0; chunkStart < Num; chunkStart += chunkSize)
+	{
+		const int32 num = FMath::Min(chunkSize, Num - chunkStart);
+		RandomStream.FillFractions(spreads, num);
+		RandomStream.FillFractions(powers, num);
+		RandomStream.FillFractions(angles, num);
+
+		//the weapon only uses the powers 1 and 0.5, so the generic pow is avoided for them
+		if (RandomPower == 0.5f)
+		{
+			for (int32 i = 0; i < num; ++i)
+			{
+				powers[i] = FMath::Sqrt(powers[i]);
+			}
+		}
+		else if (RandomPower != 1.f)
+		{
+			for (int32 i = 0; i < num; ++i)
+			{
+				powers[i] = FMath::Pow(powers[i], RandomPower);
+			}
+		}
+
+		const float spreadRange = MaxSpread - MinSpread;
+		for (int32 i = 0; i < num; ++i)
+		{
+			powers[i] *= (MinSpread + spreadRange * spreads[i]) * Modifier;
+		}
+
+		int32 i = 0;
+		const VectorRegister twoPi = VectorSetFloat1(2.f * PI);
+		for (; i + 4 <= num; i += 4)
+		{
+			const VectorRegister angle = VectorMultiply(VectorLoad(&angles[i]), twoPi);
+			VectorRegister sinAngle, cosAngle;
+			VectorSinCos(&sinAngle, &cosAngle, &angle);
+			const VectorRegister magnitude = VectorLoad(&powers[i]);
+			VectorStore(VectorMultiply(magnitude, cosAngle), &dispersionsX[i]);
+			VectorStore(VectorMultiply(magnitude, sinAngle), &dispersionsY[i]);
+		}
+		for (; i < num; ++i)
+		{
+			float sinAngle, cosAngle;
+			FMath::SinCos(&sinAngle, &cosAngle, angles[i] * 2.f * PI);
+			dispersionsX[i] = powers[i] * cosAngle;
+			dispersionsY[i] = powers[i] * sinAngle;
+		}
+
+		for (i = 0; i < num; ++i)
+		{
+			FVector& direction = OutDirections[chunkStart + i];
+			direction = baseDirection;
+			direction.Y += dispersionsX[i];
+			direction.Z += dispersionsY[i];
+			direction.Normalize();
+		}
+	}
+}
+
+static void BenchmarkBulletSpread(const TArray<FString>& Args)
+{
+	//a 12 pellet shotgun like in the training data
+	const int32 pelletsPerShot = 12;
+	const int32 numShots = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+	const FVector shotDirection = FVector(1.f, 0.2f, -0.1f).GetSafeNormal();
+	const float modifier = 1.3f;
+
+	TArray<FVector> scalarDirections;
+	TArray<FVector> batchDirections;
+	scalarDirections.SetNumUninitialized(numShots * pelletsPerShot);
+	batchDirections.SetNumUninitialized(numShots * pelletsPerShot);
+
+	//the previous per pellet calculation of AShooterWeapon
+	double startTime = FPlatformTime::Seconds();
+	for (FVector& direction : scalarDirections)
+	{
+		const float currentSpread = FMath::FRandRange(0.001f, 0.1f);
+		const float random = FMath::FRandRange(0.f, 1.f);
+		const float randomSinCos = FMath::FRandRange(0.f, 2 * PI);
+		const float randomPowered = FMath::Pow(random, 1.f);
+		direction = shotDirection;
+		direction.Y += randomPowered * currentSpread * FMath::Cos(randomSinCos) * modifier;
+		direction.Z += randomPowered * currentSpread * FMath::Sin(randomSinCos) * modifier;
+		direction.Normalize();
+	}
+	const double scalarSeconds = FPlatformTime::Seconds() - startTime;
+
+	FWeaponRandomStream randomStream(1337);
+	startTime = FPlatformTime::Seconds();
+	for (int32 shot = 0; shot < numShots; ++shot)
+	{
+		FBulletSpread::CalculateDirections(randomStream, shotDirection, 1.f, 0.001f, 0.1f, modifier, &batchDirections[shot * pelletsPerShot], pelletsPerShot);
+	}
+	const double batchSeconds = FPlatformTime::Seconds() - startTime;
+
+	//both have to disperse by the same amount on average
+	float scalarDeviation = 0.f;
+	float batchDeviation = 0.f;
+	for (int32 i = 0; i < scalarDirections.Num(); ++i)
+	{
+		scalarDeviation += FVector::Dist(scalarDirections[i], shotDirection);
+		batchDeviation += FVector::Dist(batchDirections[i], shotDirection);
+	}
+
+	const double nanosecondsPerPellet = 1e9 / scalarDirections.Num();
+	UE_LOG(LogTemp, Log, TEXT("Bullet spread benchmark (%d shots with %d pellets): scalar %.2f ns/pellet, batch %.2f ns/pellet, mean deviation %.4f vs %.4f"),
+		numShots, pelletsPerShot, scalarSeconds * nanosecondsPerPellet, batchSeconds * nanosecondsPerPellet,
+		scalarDeviation / scalarDirections.Num(), batchDeviation / batchDirections.Num());
+}
+
+static FAutoConsoleCommand BenchmarkBulletSpreadCommand(
+	TEXT("Game.BenchmarkBulletSpread"),
+	TEXT("Compares the per pellet cost of the scalar bullet spread and FBulletSpread for 12 pellet shots. Optional argument: number of shots"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkBulletSpread)
+);
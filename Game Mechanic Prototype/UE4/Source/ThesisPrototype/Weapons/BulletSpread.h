@@ -0,0 +1,54 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Counter-based random numbers, the n-th number of a stream only depends on the seed and n.
+ * Numbers can be generated in batches without a dependency from one number to the next one and a stream can be replayed from any counter.
+ */
+struct THESISPROTOTYPE_API FWeaponRandomStream
+{
+	FWeaponRandomStream() = default;
+	explicit FWeaponRandomStream(uint64 InSeed) : seed(InSeed) {}
+
+	FORCEINLINE void Initialize(uint64 InSeed) { seed = InSeed; counter = 0; }
+
+	//in [0, 1)
+	FORCEINLINE float GetFraction() { return toFraction(hash(seed, counter++)); }
+	FORCEINLINE float FRandRange(float Min, float Max) { return Min + (Max - Min) * GetFraction(); }
+
+	//same numbers as Num calls of GetFraction
+	void FillFractions(float* OutFractions, int32 Num);
+
+	FORCEINLINE uint64 GetSeed() const { return seed; }
+	FORCEINLINE uint64 GetCounter() const { return counter; }
+
+private:
+	//splitmix64 finalizer of the counter-th element of the seed's sequence
+	static FORCEINLINE uint64 hash(uint64 Seed, uint64 Counter)
+	{
+		uint64 z = Seed + (Counter + 1) * 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	//the upper 24 bits are exactly representable as float
+	static FORCEINLINE float toFraction(uint64 Hash) { return static_cast<uint32>(Hash >> 40) * (1.f / 16777216.f); }
+
+private:
+	uint64 seed = 0;
+	uint64 counter = 0;
+};
+
+/**
+ * Bullet spread according to http://symthic.com/bf1-general-info?p=misc for all pellets of a shot at once.
+ * Every pellet gets a random spread between MinSpread and MaxSpread and is dispersed by random^RandomPower * spread * Modifier in a random direction.
+ */
+struct THESISPROTOTYPE_API FBulletSpread
+{
+	//offsets Direction by the dispersion of every pellet (y = horizontal, z = vertical) and normalizes it
+	static void CalculateDirections(FWeaponRandomStream& RandomStream, const FVector& Direction, float RandomPower, float MinSpread, float MaxSpread, float Modifier, FVector* OutDirections, int32 Num);
+};
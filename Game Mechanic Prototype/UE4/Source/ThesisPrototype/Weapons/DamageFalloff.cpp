@@ -0,0 +1,101 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "DamageFalloff.h"
+#include "Curves/RichCurve.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+void FDamageFalloff::Build(const FVector2D& MaxDamageWithDistance, const FVector2D& MinDamageWithDistance)
+{
+	const float times[3] = { 0.f, MaxDamageWithDistance.Y, MinDamageWithDistance.Y };
+	const float values[3] = { MaxDamageWithDistance.X, MaxDamageWithDistance.X, MinDamageWithDistance.X };
+
+	//insert the keys like FRichCurve::AddKey, a key with the same time as an existing one goes in front of it
+	int32 numKeys = 0;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		int32 index = 0;
+		while (index < numKeys && keyTimes[index] < times[i])
+		{
+			++index;
+		}
+		for (int32 j = numKeys; j > index; --j)
+		{
+			keyTimes[j] = keyTimes[j - 1];
+			keyValues[j] = keyValues[j - 1];
+		}
+		keyTimes[index] = times[i];
+		keyValues[index] = values[i];
+		++numKeys;
+	}
+}
+
+void FDamageFalloff::EvaluateBatch(const float* Distances, float* OutDamages, int32 Num) const
+{
+	for (int32 i = 0; i < Num; ++i)
+	{
+		OutDamages[i] = Evaluate(Distances[i]);
+	}
+}
+
+static void BenchmarkDamageFalloff(const TArray<FString>& Args)
+{
+	//a 12 pellet shotgun like in the training data
+	const int32 pelletsPerShot = 12;
+	const int32 numShots = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+	const FVector2D maxDamageWithDistance(20.f, 1000.f);
+	const FVector2D minDamageWithDistance(5.f, 10000.f);
+
+	FRichCurve curve;
+	curve.AddKey(0.f, maxDamageWithDistance.X);
+	curve.AddKey(maxDamageWithDistance.Y, maxDamageWithDistance.X);
+	curve.AddKey(minDamageWithDistance.Y, minDamageWithDistance.X);
+
+	FDamageFalloff falloff;
+	falloff.Build(maxDamageWithDistance, minDamageWithDistance);
+
+	//hits are traced up to 10000 units
+	FRandomStream randomStream(1337);
+	TArray<float> distances;
+	distances.SetNumUninitialized(numShots * pelletsPerShot);
+	for (float& distance : distances)
+	{
+		distance = randomStream.FRandRange(0.f, 12000.f);
+	}
+
+	TArray<float> curveDamages;
+	TArray<float> falloffDamages;
+	curveDamages.SetNumUninitialized(distances.Num());
+	falloffDamages.SetNumUninitialized(distances.Num());
+
+	double startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < distances.Num(); ++i)
+	{
+		curveDamages[i] = curve.Eval(distances[i]);
+	}
+	const double curveSeconds = FPlatformTime::Seconds() - startTime;
+
+	startTime = FPlatformTime::Seconds();
+	for (int32 shot = 0; shot < numShots; ++shot)
+	{
+		const int32 offset = shot * pelletsPerShot;
+		falloff.EvaluateBatch(&distances[offset], &falloffDamages[offset], pelletsPerShot);
+	}
+	const double falloffSeconds = FPlatformTime::Seconds() - startTime;
+
+	int32 numMismatches = 0;
+	for (int32 i = 0; i < distances.Num(); ++i)
+	{
+		numMismatches += curveDamages[i] != falloffDamages[i] ? 1 : 0;
+	}
+
+	const double nanosecondsPerHit = 1e9 / distances.Num();
+	UE_LOG(LogTemp, Log, TEXT("Damage falloff benchmark (%d shots with %d pellets): FRichCurve %.2f ns/hit, FDamageFalloff %.2f ns/hit, %d mismatches"),
+		numShots, pelletsPerShot, curveSeconds * nanosecondsPerHit, falloffSeconds * nanosecondsPerHit, numMismatches);
+}
+
+static FAutoConsoleCommand BenchmarkDamageFalloffCommand(
+	TEXT("Game.BenchmarkDamageFalloff"),
+	TEXT("Compares the per hit cost of FRichCurve and FDamageFalloff for 12 pellet shots. Optional argument: number of shots"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkDamageFalloff)
+);
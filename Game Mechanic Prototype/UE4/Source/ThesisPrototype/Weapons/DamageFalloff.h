@@ -0,0 +1,37 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Piecewise linear damage over distance with the keys (0, max damage), (max damage distance, max damage) and (min damage distance, min damage).
+ * Returns exactly the same values as a FRichCurve with these keys (linear interpolation, constant extrapolation),
+ * but it doesn't allocate when the keys change and evaluates without searching the keys.
+ */
+struct THESISPROTOTYPE_API FDamageFalloff
+{
+	//x = damage, y = distance, like AShooterWeapon::maxDamageWithDistance and minDamageWithDistance
+	void Build(const FVector2D& MaxDamageWithDistance, const FVector2D& MinDamageWithDistance);
+
+	FORCEINLINE float Evaluate(float Distance) const
+	{
+		//same key selection as FRichCurve::Eval
+		if (Distance <= keyTimes[0])
+			return keyValues[0];
+		if (Distance >= keyTimes[2])
+			return keyValues[2];
+
+		const int32 segment = Distance >= keyTimes[1] ? 1 : 0;
+		const float alpha = (Distance - keyTimes[segment]) / (keyTimes[segment + 1] - keyTimes[segment]);
+		return FMath::Lerp(keyValues[segment], keyValues[segment + 1], alpha);
+	}
+
+	//evaluates all pellets of a shot at once
+	void EvaluateBatch(const float* Distances, float* OutDamages, int32 Num) const;
+
+private:
+	//sorted like the keys of the FRichCurve
+	float keyTimes[3] = { 0.f, 0.f, 0.f };
+	float keyValues[3] = { 0.f, 0.f, 0.f };
+};
@@ -10,14 +10,15 @@
 #include "Camera/CameraShake.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "ChangingGuns.h"
-#include "TimerManager.h"
 #include "UnrealNetwork.h"
-#include "Curves/CurveFloat.h"
 #include "GameFramework/Character.h"
 #include "Pawns/ShooterCharacter.h"
 #include "ChangingGunsPlayerState.h"
+#include "ChangingGunsGameMode.h"
 #include "Sound/SoundCue.h"
 #include "Components/HealthComponent.h"
+#include "Async/ParallelFor.h"
+#include "ShooterEffectPool.h"
 
 static int32 DebugWeaponDrawing = 0;
 FAutoConsoleVariableRef CVARDebugWeaponDrawing (
@@ -27,6 +28,31 @@ FAutoConsoleVariableRef CVARDebugWeaponDrawing (
 	ECVF_Cheat
 );
 
+static int32 ParallelPelletTraces = 1;
+FAutoConsoleVariableRef CVARParallelPelletTraces (
+	TEXT("Game.ParallelPelletTraces"),
+	ParallelPelletTraces,
+	TEXT("Trace the pellets of multi-pellet shots (e.g. shotguns) in parallel"),
+	ECVF_Default
+);
+
+static int32 WeaponEffects = 1;
+FAutoConsoleVariableRef CVARWeaponEffects (
+	TEXT("Game.WeaponEffects"),
+	WeaponEffects,
+	TEXT("Play the muzzle, tracer and impact effects, camera shakes and fire sounds of weapons, e.g., 0 for benchmarks"),
+	ECVF_Default
+);
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Fire"), STAT_WeaponFire, STATGROUP_ChangingGuns);
+//ApplyPointDamage including the health components
+DECLARE_CYCLE_STAT(TEXT("Weapon Damage"), STAT_WeaponDamage, STATGROUP_ChangingGuns);
+//muzzle, tracer and impact effects and fire sounds
+DECLARE_CYCLE_STAT(TEXT("Weapon Effects"), STAT_WeaponEffects, STATGROUP_ChangingGuns);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Shots"), STAT_WeaponShots, STATGROUP_ChangingGuns);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Traces"), STAT_WeaponTraces, STATGROUP_ChangingGuns);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Hits"), STAT_WeaponHits, STATGROUP_ChangingGuns);
+
 
 float FOwnerBasedModifier::GetCurrentModifier(AShooterCharacter* Character)
 {
@@ -69,6 +95,8 @@ AShooterWeapon::AShooterWeapon()
 	spreadModifier.Crouching = 0.5f;
 	spreadModifier.Aiming = 0.2;
 
+	impactEffectCullDistance = 50.f * PROJECT_MEASURING_UNIT_FACTOR_TO_M;
+
 	recoilModifier.Moving = 1.3f;
 	recoilModifier.Crouching = 0.5f;
 	recoilModifier.Aiming = 0.2f;
@@ -91,7 +119,8 @@ void AShooterWeapon::SetMinDamageWithDistance(const FVector2D& MinDamageWithDist
 
 void AShooterWeapon::SetRateOfFire(int32 RateOfFire)
 {
-	rateOfFire = RateOfFire;
+	//at least one bullet per minute, otherwise there is no time between the shots
+	rateOfFire = FMath::Max(1, RateOfFire);
 	timeBetweenShots = 60.f / rateOfFire;
 }
 
@@ -114,6 +143,9 @@ void AShooterWeapon::BeginPlay()
 {
 	Super::BeginPlay();
 
+	effectPool = AShooterEffectPool::Get(GetWorld());
+	initializeRandomStream();
+
 	SetRateOfFire(rateOfFire);
 	SetBulletsPerMagazine(bulletsPerMagazine);
 	buildDamageCurve();
@@ -123,7 +155,39 @@ void AShooterWeapon::BeginPlay()
 void AShooterWeapon::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	compensateRecoil(DeltaTime);
+
+	const float time = GetWorld()->TimeSeconds;
+	if (bWantsToFire && nextShotTime <= time)
+	{
+		//all shots which are owed since the last frame are fired at once, a long hitch must not overflow the count
+		int32 numShots = fireMode == EFireMode::Automatic ? FMath::Max(1, FMath::FloorToInt((time - nextShotTime) / timeBetweenShots) + 1) : 1;
+		if (!bUnlimitiedBullets)
+		{
+			numShots = FMath::Clamp(numShots, 1, currentBulletsInMagazine);
+		}
+		fire(numShots);
+	}
+
+	decreaseBulletSpread(time);
+
+	if (bIsReloading && reloadFinishTime <= time)
+	{
+		if (bIsReloadingMagazine)
+		{
+			reloadMagazine();
+		}
+		else
+		{
+			reloadStock();
+		}
+	}
+
+	if (!currentRecoil.IsZero())
+	{
+		compensateRecoil(DeltaTime);
+	}
+
+	updateTickEnabled();
 }
 
 void AShooterWeapon::StartFire()
@@ -132,13 +196,14 @@ void AShooterWeapon::StartFire()
 	{
 		return;
 	}
-	float firstDelay = FMath::Max(lastFireTime + timeBetweenShots - GetWorld()->TimeSeconds, 0.f);
-	GetWorldTimerManager().SetTimer(timerHandle_AutomaticFire, this, &AShooterWeapon::fire, timeBetweenShots, true, firstDelay);
+	bWantsToFire = true;
+	nextShotTime = FMath::Max(lastFireTime + timeBetweenShots, GetWorld()->TimeSeconds);
+	updateTickEnabled();
 }
 
 void AShooterWeapon::StopFire()
 {
-	GetWorldTimerManager().ClearTimer(timerHandle_AutomaticFire);
+	bWantsToFire = false;
 }
 
 void AShooterWeapon::StartMagazineReloading()
@@ -148,10 +213,11 @@ void AShooterWeapon::StartMagazineReloading()
 		return;
 	}
 	bIsReloading = true;
-	GetWorldTimerManager().ClearTimer(timerHandle_ReloadStock);
+	bIsReloadingMagazine = true;
 	const int bulletDifference = bulletsPerMagazine - currentBulletsInMagazine;
 	const float reloadTimeNeeded = bulletDifference == bulletsPerMagazine ? reloadTimeEmptyMagazine : singleBulletReloadTime * bulletDifference;
-	GetWorldTimerManager().SetTimer(timerHandle_ReloadMagazine, this, &AShooterWeapon::reloadMagazine, reloadTimeNeeded);
+	reloadFinishTime = GetWorld()->TimeSeconds + reloadTimeNeeded;
+	updateTickEnabled();
 	OnReloadStateChangedEvent.Broadcast(bIsReloading, reloadTimeNeeded, currentBulletsInMagazine);
 }
 
@@ -159,16 +225,18 @@ void AShooterWeapon::Equip(AShooterCharacter* EuqippedBy)
 {
 	owningCharacter = EuqippedBy;
 	timeEquipped = GetWorld()->TimeSeconds;
+
+	if (AChangingGunsGameMode* gm = Cast<AChangingGunsGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		gm->OnActorKilledEvent.AddUniqueDynamic(this, &AShooterWeapon::onActorKilled);
+	}
 }
 
 void AShooterWeapon::Disarm()
 {
 	StopFire();
-	GetWorldTimerManager().ClearTimer(timerHandle_AutomaticFire);
-	GetWorldTimerManager().ClearTimer(timerHandle_ReloadMagazine);
-	GetWorldTimerManager().ClearTimer(timerHandle_ReloadStock);
-	GetWorldTimerManager().ClearTimer(timerHandle_SpreadDecrease);
 	bIsReloading = false;
+	bIsSpreadDecreasing = false;
 	currentBulletSpread = 0.f;
 	currentRecoil = FVector2D::ZeroVector;
 
@@ -178,10 +246,64 @@ void AShooterWeapon::Disarm()
 	}
 
 	owningCharacter = nullptr;
-	PrimaryActorTick.SetTickFunctionEnable(false);
+	updateTickEnabled();
+
+	if (AChangingGunsGameMode* gm = Cast<AChangingGunsGameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		gm->OnActorKilledEvent.RemoveDynamic(this, &AShooterWeapon::onActorKilled);
+	}
 
 }
 
+void AShooterWeapon::ResetForReuse()
+{
+	Disarm();
+
+	//e.g., the muzzle effect must not play on the hidden weapon
+	if (effectPool.IsValid())
+	{
+		effectPool->StopAttachedEffects(this);
+	}
+
+	//the previous owner's listeners must not receive anything from the next owner
+	OnAmmoChangedEvent.Clear();
+	OnReloadStateChangedEvent.Clear();
+
+	//generated weapons overwrite the stats, so take them from the (blueprint) class defaults
+	const AShooterWeapon* defaults = GetClass()->GetDefaultObject<AShooterWeapon>();
+	maxDamageWithDistance = defaults->maxDamageWithDistance;
+	minDamageWithDistance = defaults->minDamageWithDistance;
+	muzzleVelocity = defaults->muzzleVelocity;
+	bulletSpreadIncrease = defaults->bulletSpreadIncrease;
+	bulletSpreadDecrease = defaults->bulletSpreadDecrease;
+	availableMagazines = defaults->availableMagazines;
+	bulletsInOneShot = defaults->bulletsInOneShot;
+	reloadTimeEmptyMagazine = defaults->reloadTimeEmptyMagazine;
+	recoilIncreasePerShot = defaults->recoilIncreasePerShot;
+	recoilDecrease = defaults->recoilDecrease;
+	fireMode = defaults->fireMode;
+	type = defaults->type;
+	bUnlimitiedBullets = defaults->bUnlimitiedBullets;
+
+	bIsAmmoLeftInMagazine = true;
+	lastFireTime = 0.f;
+	timeEquipped = 0.f;
+	statistics = FWeaponStatistics();
+	initializeRandomStream();
+
+	SetRateOfFire(defaults->rateOfFire);
+	SetBulletsPerMagazine(defaults->bulletsPerMagazine);
+	buildDamageCurve();
+}
+
+void AShooterWeapon::onActorKilled(AActor* VictimActor, AActor* KillerActor, AController* KillerController)
+{
+	if (owningCharacter && KillerActor == owningCharacter)
+	{
+		++statistics.Kills;
+	}
+}
+
 void AShooterWeapon::RefillAmmunition(int AmountOfBullets)
 {
 	int maxBullets = availableMagazines * bulletsPerMagazine;
@@ -190,26 +312,28 @@ void AShooterWeapon::RefillAmmunition(int AmountOfBullets)
 	OnAmmoChangedEvent.Broadcast(availableBulletsLeft, currentBulletsInMagazine);
 }
 
-void AShooterWeapon::applyRecoil()
+void AShooterWeapon::applyRecoil(float Modifier)
 {
 	if (FMath::IsNearlyZero(recoilIncreasePerShot.Y) && FMath::IsNearlyZero(recoilIncreasePerShot.X))
 		return;
 
+	//the controller input is ignored for remote owners, so their weapons don't need to tick for it
+	if (!owningCharacter->IsLocallyControlled())
+		return;
+
 	FVector2D recoil;
 	
 	recoil.Y = -recoilIncreasePerShot.Y;
-	recoil.X = FMath::FRandRange(-recoilIncreasePerShot.X, recoilIncreasePerShot.X);
-	recoil *= recoilModifier.GetCurrentModifier(owningCharacter);
+	recoil.X = randomStream.FRandRange(-recoilIncreasePerShot.X, recoilIncreasePerShot.X);
+	recoil *= Modifier;
 
 	owningCharacter->AddControllerPitchInput(recoil.Y);
 	owningCharacter->AddControllerYawInput(recoil.X);
 
 	currentRecoil += recoil;
-
-	PrimaryActorTick.SetTickFunctionEnable(true);
 }
 
-float AShooterWeapon::calculateRecoilCompensationDelta(float DeltaTime, float CurrentRecoil)
+float AShooterWeapon::calculateRecoilCompensationDelta(float DeltaTime, float CurrentRecoil, float Modifier)
 {
 	//calculations according to http://symthic.com/bf1-general-info?p=misc
 	//C = Some constant(approx. 5.0)
@@ -220,7 +344,7 @@ float AShooterWeapon::calculateRecoilCompensationDelta(float DeltaTime, float Cu
 
 	//Decrease = RecoilTerm * RecoilDecrease * DeltaTime * TimeSinceLastShot^0.5 * C
 	const float timeSinceLastShot = GetWorld()->TimeSeconds - lastFireTime;
-	float delta = recoilTerm * recoilDecrease * recoilModifier.GetCurrentModifier(owningCharacter) * DeltaTime * FMath::Pow(timeSinceLastShot, 0.5f) * magicConstant;
+	float delta = recoilTerm * recoilDecrease * Modifier * DeltaTime * FMath::Pow(timeSinceLastShot, 0.5f) * magicConstant;
 
 	delta *= CurrentRecoil > 0.f ? -1.f : 1.f;
 
@@ -230,8 +354,9 @@ float AShooterWeapon::calculateRecoilCompensationDelta(float DeltaTime, float Cu
 void AShooterWeapon::compensateRecoil(float DeltaTime)
 {
 	FVector2D recoilDelta;
-	recoilDelta.X = calculateRecoilCompensationDelta(DeltaTime, currentRecoil.X);
-	recoilDelta.Y = calculateRecoilCompensationDelta(DeltaTime, currentRecoil.Y);
+	const float currentRecoilModifier = recoilModifier.GetCurrentModifier(owningCharacter);
+	recoilDelta.X = calculateRecoilCompensationDelta(DeltaTime, currentRecoil.X, currentRecoilModifier);
+	recoilDelta.Y = calculateRecoilCompensationDelta(DeltaTime, currentRecoil.Y, currentRecoilModifier);
 
 	currentRecoil += recoilDelta;
 
@@ -241,7 +366,6 @@ void AShooterWeapon::compensateRecoil(float DeltaTime)
 	if(FMath::IsNearlyZero(currentRecoil.X, .25f) && FMath::IsNearlyZero(currentRecoil.Y, .25f))
 	{
 		currentRecoil = FVector2D::ZeroVector;
-		PrimaryActorTick.SetTickFunctionEnable(false);
 	}
 }
 
@@ -263,7 +387,8 @@ void AShooterWeapon::reloadMagazine()
 void AShooterWeapon::startStockReloading()
 {
 	bIsReloading = true;
-	GetWorldTimerManager().SetTimer(timerHandle_ReloadStock, this, &AShooterWeapon::reloadStock, singleBulletReloadTime);
+	bIsReloadingMagazine = false;
+	reloadFinishTime = lastFireTime + singleBulletReloadTime;
 	OnReloadStateChangedEvent.Broadcast(bIsReloading, singleBulletReloadTime, currentBulletsInMagazine);
 }
 
@@ -273,13 +398,32 @@ void AShooterWeapon::reloadStock()
 	OnReloadStateChangedEvent.Broadcast(bIsReloading, 0.f, currentBulletsInMagazine);
 }
 
-void AShooterWeapon::decreaseBulletSpread()
+void AShooterWeapon::decreaseBulletSpread(float Time)
+{
+	//the spread decreases once per second
+	while(bIsSpreadDecreasing && nextSpreadDecreaseTime <= Time)
+	{
+		currentBulletSpread -= bulletSpreadDecrease;
+		nextSpreadDecreaseTime += 1.f;
+		if(currentBulletSpread <= 0)
+		{
+			currentBulletSpread = 0;
+			bIsSpreadDecreasing = false;
+		}
+	}
+}
+
+void AShooterWeapon::initializeRandomStream()
 {
-	currentBulletSpread -= bulletSpreadDecrease;
-	if(currentBulletSpread <= 0)
+	randomStream.Initialize(static_cast<uint32>(FSessionSeed::NextStreamSeed(TEXT("Weapon"))));
+}
+
+void AShooterWeapon::updateTickEnabled()
+{
+	const bool bShouldTick = bWantsToFire || bIsReloading || bIsSpreadDecreasing || !currentRecoil.IsZero();
+	if (PrimaryActorTick.IsTickFunctionEnabled() != bShouldTick)
 	{
-		currentBulletSpread = 0;
-		GetWorldTimerManager().ClearTimer(timerHandle_SpreadDecrease);
+		PrimaryActorTick.SetTickFunctionEnable(bShouldTick);
 	}
 }
 
@@ -297,10 +441,7 @@ float AShooterWeapon::getDamageMultiplierFor(EPhysicalSurface SurfaceType)
 
 void AShooterWeapon::buildDamageCurve()
 {
-	damageCurve.GetRichCurve()->Reset();
-	damageCurve.GetRichCurve()->AddKey(0.f, maxDamageWithDistance.X);
-	damageCurve.GetRichCurve()->AddKey(maxDamageWithDistance.Y, maxDamageWithDistance.X);
-	damageCurve.GetRichCurve()->AddKey(minDamageWithDistance.Y, minDamageWithDistance.X);
+	damageFalloff.Build(maxDamageWithDistance, minDamageWithDistance);
 }
 
 void AShooterWeapon::updateSingleBulletReloadTime()
@@ -308,20 +449,7 @@ void AShooterWeapon::updateSingleBulletReloadTime()
 	singleBulletReloadTime = reloadTimeEmptyMagazine / bulletsPerMagazine;
 }
 
-FVector2D AShooterWeapon::calculateBulletSpreadDispersion(float RandomPower, float CurrentSpread)
-{
-	const float random = FMath::FRandRange(0.f, 1.f);
-	const float randomSinCos = FMath::FRandRange(0.f, 2 * PI);
-	const float randomPowered = FMath::Pow(random, RandomPower);
-	const float horizontalDispersion = randomPowered * CurrentSpread * FMath::Cos(randomSinCos);
-	const float verticalDispersion = randomPowered * CurrentSpread * FMath::Sin(randomSinCos);
-	FVector2D spreadDispersion = FVector2D(horizontalDispersion, verticalDispersion);
-	spreadDispersion *= spreadModifier.GetCurrentModifier(owningCharacter);
-	return spreadDispersion;
-}
-
-
-void AShooterWeapon::fire()
+void AShooterWeapon::fire(int32 NumShots)
 {
 	if(!bIsAmmoLeftInMagazine)
 	{
@@ -329,125 +457,221 @@ void AShooterWeapon::fire()
 		StopFire();
 		return;
 	}
-	//trace the world, from pawn eyes to crosshair location
 
-	//but fire anyway because you are a client
-	if(owningCharacter)
+	if(!owningCharacter)
 	{
-		FVector eyeLocation;
-		FRotator eyeRotator;
-		owningCharacter->GetActorEyesViewPoint(eyeLocation, eyeRotator);
+		StopFire();
+		return;
+	}
 
-		FVector shotDirection = eyeRotator.Vector();
+	SCOPE_CYCLE_COUNTER(STAT_WeaponFire);
 
+	//trace the world, from pawn eyes to crosshair location
+	FVector eyeLocation;
+	FRotator eyeRotator;
+	owningCharacter->GetActorEyesViewPoint(eyeLocation, eyeRotator);
+
+	//the owner doesn't change its movement while the shots of a frame are fired
+	const float currentSpreadModifier = spreadModifier.GetCurrentModifier(owningCharacter);
+	const float currentRecoilModifier = recoilModifier.GetCurrentModifier(owningCharacter);
+
+	//the pellets of all shots of this frame are traced together and every hit actor receives the summed damage of its pellets at once
+	const int32 numPellets = FMath::Max(1, bulletsInOneShot);
+	const int32 numTraces = NumShots * numPellets;
+	INC_DWORD_STAT_BY(STAT_WeaponShots, NumShots);
+	INC_DWORD_STAT_BY(STAT_WeaponTraces, numTraces);
+	TArray<FVector, TInlineAllocator<4>> shotDirections;
+	TArray<FVector, TInlineAllocator<16>> traceEnds;
+	shotDirections.SetNumUninitialized(NumShots);
+	traceEnds.SetNumUninitialized(numTraces);
+	for(int32 shot = 0; shot < NumShots; ++shot)
+	{
+		const float shotTime = nextShotTime + shot * timeBetweenShots;
+		decreaseBulletSpread(shotTime);
 
-		//bullet spread calculations according to http://symthic.com/bf1-general-info?p=misc
+		FVector shotDirection = eyeRotator.Vector();
 		if(currentBulletSpread > 0.f)
 		{
-			const FVector2D spread = calculateBulletSpreadDispersion(type == EWeaponType::Shotgun ? 1.0f : 0.5f, currentBulletSpread);
-			shotDirection.Y += spread.X;
-			shotDirection.Z += spread.Y;
-			shotDirection.Normalize();
+			FBulletSpread::CalculateDirections(randomStream, shotDirection, type == EWeaponType::Shotgun ? 1.0f : 0.5f, currentBulletSpread, currentBulletSpread, currentSpreadModifier, &shotDirection, 1);
 		}
 		currentBulletSpread += bulletSpreadIncrease;
-		if (!GetWorldTimerManager().IsTimerActive(timerHandle_SpreadDecrease))
+		if(!bIsSpreadDecreasing)
 		{
-			GetWorldTimerManager().SetTimer(timerHandle_SpreadDecrease, this, &AShooterWeapon::decreaseBulletSpread, 1.f, true, timeBetweenShots);
+			bIsSpreadDecreasing = true;
+			nextSpreadDecreaseTime = shotTime + timeBetweenShots;
 		}
+		shotDirections[shot] = shotDirection;
 
-		for(int32 i = 0; i < bulletsInOneShot; ++i)
+		FVector* pelletDirections = &traceEnds[shot * numPellets];
+		if(numPellets > 1)
 		{
-			FVector bulletShotDirection = shotDirection;
-			if(bulletsInOneShot > 1)
-			{
-				const FVector2D spread = calculateBulletSpreadDispersion(1.0f, FMath::FRandRange(0.001f, 0.1f));
-				bulletShotDirection.Y += spread.X;
-				bulletShotDirection.Z += spread.Y;
-				bulletShotDirection.Normalize();
-			}
-			FVector traceEnd = eyeLocation + bulletShotDirection * 10000;
+			FBulletSpread::CalculateDirections(randomStream, shotDirection, 1.0f, 0.001f, 0.1f, currentSpreadModifier, pelletDirections, numPellets);
+		}
+		else
+		{
+			pelletDirections[0] = shotDirection;
+		}
+		for(int32 i = 0; i < numPellets; ++i)
+		{
+			pelletDirections[i] = eyeLocation + pelletDirections[i] * 10000;
+		}
+	}
 
-			FCollisionQueryParams queryParams;
-			queryParams.AddIgnoredActor(owningCharacter);
-			queryParams.AddIgnoredActor(this);
-			queryParams.bTraceComplex = true; //gives us the exact result because traces every triangle instead of a simple collider
-			queryParams.bReturnPhysicalMaterial = true;
+	FCollisionQueryParams queryParams;
+	queryParams.AddIgnoredActor(owningCharacter);
+	queryParams.AddIgnoredActor(this);
+	queryParams.bTraceComplex = true; //gives us the exact result because traces every triangle instead of a simple collider
+	queryParams.bReturnPhysicalMaterial = true;
 
-			FVector tracerEndPoint = traceEnd;
-			EPhysicalSurface surfaceType = SurfaceType_Default;
+	TArray<FHitResult, TInlineAllocator<16>> hitResults;
+	TArray<bool, TInlineAllocator<16>> isBlockingHit;
+	hitResults.SetNum(numTraces);
+	isBlockingHit.SetNumZeroed(numTraces);
 
-			FHitResult hitResult;
-			if (GetWorld()->LineTraceSingleByChannel(hitResult, eyeLocation, traceEnd, COLLISION_WEAPON, queryParams))
-			{
-				//is blocking hit! -> process damage
-				float actualDamage = damageCurve.GetRichCurveConst()->Eval(hitResult.Distance);
+	const UWorld* world = GetWorld();
+	auto tracePellet = [&](int32 Index)
+	{
+		isBlockingHit[Index] = world->LineTraceSingleByChannel(hitResults[Index], eyeLocation, traceEnds[Index], COLLISION_WEAPON, queryParams);
+	};
+	//single pellet shots of automatic weapons are too few per frame to pay for a task graph batch
+	if(numPellets > 1 && ParallelPelletTraces > 0)
+	{
+		ParallelFor(numTraces, tracePellet);
+	}
+	else
+	{
+		for(int32 i = 0; i < numTraces; ++i)
+		{
+			tracePellet(i);
+		}
+	}
 
-				AActor* hitActor = hitResult.GetActor();
+	TArray<float, TInlineAllocator<16>> pelletDamages;
+	TArray<EPhysicalSurface, TInlineAllocator<16>> surfaceTypes;
+	pelletDamages.SetNumUninitialized(numTraces);
+	surfaceTypes.SetNumUninitialized(numTraces);
+	for(int32 i = 0; i < numTraces; ++i)
+	{
+		pelletDamages[i] = hitResults[i].Distance;
+	}
+	damageFalloff.EvaluateBatch(pelletDamages.GetData(), pelletDamages.GetData(), numTraces);
 
-				surfaceType = UPhysicalMaterial::DetermineSurfaceType(hitResult.PhysMaterial.Get());
+	struct FActorDamage
+	{
+		AActor* Actor;
+		float Damage;
+		int32 FirstPellet;
+	};
+	TArray<FActorDamage, TInlineAllocator<16>> actorDamages;
+	for(int32 i = 0; i < numTraces; ++i)
+	{
+		surfaceTypes[i] = SurfaceType_Default;
+		if(!isBlockingHit[i])
+			continue;
+
+		surfaceTypes[i] = UPhysicalMaterial::DetermineSurfaceType(hitResults[i].PhysMaterial.Get());
+		AActor* hitActor = hitResults[i].GetActor();
+		if(!hitActor)
+			continue;
+
+		const float actualDamage = pelletDamages[i] * getDamageMultiplierFor(surfaceTypes[i]);
+		FActorDamage* actorDamage = actorDamages.FindByPredicate([hitActor](const FActorDamage& Other) { return Other.Actor == hitActor; });
+		if(actorDamage)
+		{
+			actorDamage->Damage += actualDamage;
+		}
+		else
+		{
+			actorDamages.Add({ hitActor, actualDamage, i });
+		}
+	}
 
-				actualDamage *= getDamageMultiplierFor(surfaceType);
+	{
+		SCOPE_CYCLE_COUNTER(STAT_WeaponDamage);
+		for(const FActorDamage& actorDamage : actorDamages)
+		{
+			//kills are counted in onActorKilled because the health components apply the damage at the end of the frame
+			if(UHealthComponent::FindHealthComponent(actorDamage.Actor))
+			{
+				UGameplayStatics::ApplyPointDamage(actorDamage.Actor, actorDamage.Damage, shotDirections[actorDamage.FirstPellet / numPellets], hitResults[actorDamage.FirstPellet], owningCharacter->GetInstigatorController(), owningCharacter, damageType);
+			}
+		}
+	}
 
-				if(UHealthComponent* healtComp = Cast<UHealthComponent>(hitActor->GetComponentByClass(UHealthComponent::StaticClass())))
+	{
+		SCOPE_CYCLE_COUNTER(STAT_WeaponEffects);
+		for(int32 i = 0; i < numTraces; ++i)
+		{
+			FVector tracerEndPoint = traceEnds[i];
+			if(isBlockingHit[i])
+			{
+				INC_DWORD_STAT(STAT_WeaponHits);
+				if (WeaponEffects > 0)
 				{
-					UGameplayStatics::ApplyPointDamage(hitActor, actualDamage, shotDirection, hitResult, owningCharacter->GetInstigatorController(), owningCharacter, damageType);
-					if(healtComp->GetHealth() <= 0)
-					{
-						++statistics.Kills;
-					}
+					playImpactEffects(surfaceTypes[i], hitResults[i].ImpactPoint);
 				}
-
-				playImpactEffects(surfaceType, hitResult.ImpactPoint);
-
-				tracerEndPoint = hitResult.ImpactPoint;
+				tracerEndPoint = hitResults[i].ImpactPoint;
 			}
 
 			if (DebugWeaponDrawing > 0)
 			{
-				DrawDebugLine(GetWorld(), eyeLocation, traceEnd, FColor::White, false, 1.f, 0, 1.f);
+				DrawDebugLine(GetWorld(), eyeLocation, traceEnds[i], FColor::White, false, 1.f, 0, 1.f);
 			}
 
-			playFireEffects(tracerEndPoint);
+			if (WeaponEffects > 0)
+			{
+				playFireEffects(tracerEndPoint);
+			}
 		}
 
-		UGameplayStatics::PlaySoundAtLocation(this, fireSound, GetActorLocation());
-
-		applyRecoil();
-
-		lastFireTime = GetWorld()->TimeSeconds;
-
-		if(!bUnlimitiedBullets)
+		//the shots of a frame would be identical voices at the same location, so they are one louder sound
+		if (WeaponEffects > 0 && effectPool.IsValid())
 		{
-			--currentBulletsInMagazine;
+			effectPool->PlaySoundAtLocation(fireSound, GetActorLocation(), 0.f, FMath::Min(FMath::Sqrt(static_cast<float>(NumShots)), 2.f));
 		}
-		bIsAmmoLeftInMagazine = currentBulletsInMagazine > 0;
-		OnAmmoChangedEvent.Broadcast(availableBulletsLeft, currentBulletsInMagazine);
+	}
 
-		if (fireMode == EFireMode::SemiAutomatic || fireMode == EFireMode::SingleFire)
-		{
-			StopFire();
-		}
+	for(int32 shot = 0; shot < NumShots; ++shot)
+	{
+		applyRecoil(currentRecoilModifier);
+	}
 
-		if (bIsAmmoLeftInMagazine && fireMode == EFireMode::SingleFire)
-		{
-			startStockReloading();
-		}
+	//the shots are owed since their exact time, which is most likely before this frame
+	lastFireTime = nextShotTime + (NumShots - 1) * timeBetweenShots;
+	nextShotTime = lastFireTime + timeBetweenShots;
+
+	if(!bUnlimitiedBullets)
+	{
+		currentBulletsInMagazine -= NumShots;
+	}
+	bIsAmmoLeftInMagazine = currentBulletsInMagazine > 0;
+	OnAmmoChangedEvent.Broadcast(availableBulletsLeft, currentBulletsInMagazine);
+
+	if (fireMode == EFireMode::SemiAutomatic || fireMode == EFireMode::SingleFire)
+	{
+		StopFire();
 	}
 
+	if (bIsAmmoLeftInMagazine && fireMode == EFireMode::SingleFire)
+	{
+		startStockReloading();
+	}
 }
 
 void AShooterWeapon::playFireEffects(const FVector& FireImpactPoint)
 {
-	if (muzzleEffect)
+	if (muzzleEffect && effectPool.IsValid())
 	{
-		UGameplayStatics::SpawnEmitterAttached(muzzleEffect, meshComp, muzzleSocketName);
+		effectPool->SpawnEmitterAttached(muzzleEffect, meshComp, muzzleSocketName);
 	}
 
-	if (tracerEffect)
+	if (tracerEffect && effectPool.IsValid())
 	{
 		FVector muzzleLocation = meshComp->GetSocketLocation(muzzleSocketName);
-		UParticleSystemComponent* particleSystem = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), tracerEffect, muzzleLocation);
-		particleSystem->SetVectorParameter(tracerTargetName, FireImpactPoint);
+		if (UParticleSystemComponent* particleSystem = effectPool->SpawnEmitterAtLocation(tracerEffect, muzzleLocation))
+		{
+			particleSystem->SetVectorParameter(tracerTargetName, FireImpactPoint);
+		}
 	}
 
 	if(APawn* owner = Cast<APawn>(GetOwner()))
@@ -475,12 +699,12 @@ void AShooterWeapon::playImpactEffects(EPhysicalSurface SurfaceType, const FVect
 		break;
 	}
 
-	if (selectedEffect)
+	if (selectedEffect && effectPool.IsValid())
 	{
 		FVector muzzleLocation = meshComp->GetSocketLocation(muzzleSocketName);
 
 		FVector shotDirection = ImpactPoint - muzzleLocation;
 		shotDirection.Normalize();
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), selectedEffect, ImpactPoint, shotDirection.Rotation());
+		effectPool->SpawnEmitterAtLocation(selectedEffect, ImpactPoint, shotDirection.Rotation(), impactEffectCullDistance);
 	}
 }
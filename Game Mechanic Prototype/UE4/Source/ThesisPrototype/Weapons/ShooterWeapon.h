@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "DamageFalloff.h"
+#include "BulletSpread.h"
 #include "ShooterWeapon.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnAmmoChangedEvent, int, overallAvailableBulletsLeftToShoot, int, amountOfBulletsLeftInMagazine);
@@ -15,10 +17,10 @@ class UDamageType;
 class UParticleSystem;
 class UCameraShake;
 class UCurveFloat;
-struct FRuntimeFloatCurve;
 class AShooterCharacter;
 class UAudioComponent;
 class USoundCue;
+class AShooterEffectPool;
 
 UENUM(BlueprintType)
 enum class EWeaponType : uint8
@@ -101,6 +103,10 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon|FX")
 	UParticleSystem* tracerEffect;
 
+	//impacts farther away from every local player aren't shown
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon|FX")
+	float impactEffectCullDistance;
+
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon")
 	TSubclassOf<UCameraShake> fireCamShake;
 
@@ -116,7 +122,7 @@ protected:
 	FVector2D minDamageWithDistance;
 
 	// bullets per minute fired
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Weapon", meta = (ClampMin = 1))
 	int32 rateOfFire;
 
 	//this value hast absolutely no effect. this is just needed for feeding into the generator!
@@ -195,6 +201,9 @@ public:
 	//call when the weapon is stored inventory
 	virtual void Disarm();
 
+	//restores the class defaults, full ammo and empty statistics, called by the weapon pool before the weapon is used again
+	virtual void ResetForReuse();
+
 	UFUNCTION(BlueprintCallable, Category="Weapon|Ammo")
 	virtual void RefillAmmunition(int AmountOfBullets);
 
@@ -210,9 +219,11 @@ public:
 	FORCEINLINE FVector2D GetRecoilIncreasePerShot() const { return recoilIncreasePerShot; }
 	FORCEINLINE float GetRecoilDecrease() const { return recoilDecrease; }
 	FORCEINLINE int32 GetBulletsPerMagazine() const { return bulletsPerMagazine; }
+	FORCEINLINE int32 GetCurrentBulletsInMagazine() const { return currentBulletsInMagazine; }
 	FORCEINLINE int32 GetBulletsInOneShot() const { return bulletsInOneShot; }
 	FORCEINLINE float GetReloadTimeEmptyMagazine() const { return reloadTimeEmptyMagazine; }
 	FORCEINLINE FWeaponStatistics GetWeaponStatistics() const { return statistics; }
+	FORCEINLINE bool IsFiring() const { return bWantsToFire; }
 
 	FORCEINLINE void SetType(EWeaponType Type) { type = Type; }
 	FORCEINLINE void SetFireMode(EFireMode Firemode) {  fireMode = Firemode; }
@@ -234,20 +245,29 @@ protected:
 	
 	void playFireEffects(const FVector& FireImpactPoint);
 	void playImpactEffects(EPhysicalSurface SurfaceType, const FVector& ImpactPoint);
-	void fire();
+	//fires NumShots shots, the first one at nextShotTime and the others timeBetweenShots apart
+	void fire(int32 NumShots);
 	void reloadMagazine();
 	void startStockReloading();
 	void reloadStock();
-	//calculates bullet spread dispersion (x = horizontal, y = vertical)
-	FVector2D calculateBulletSpreadDispersion(float RandomPower, float CurrentSpread);
-	void decreaseBulletSpread();
-	void applyRecoil();
+	//applies the spread decreases which are due until Time
+	void decreaseBulletSpread(float Time);
+	//the weapon only ticks while it fires, reloads, decreases its spread or compensates recoil
+	void updateTickEnabled();
+	//every spawned or reused weapon gets the next weapon stream of the session
+	void initializeRandomStream();
+	//Modifier is the current recoil modifier of the owner
+	void applyRecoil(float Modifier);
 	void compensateRecoil(float DeltaTime);
-	float calculateRecoilCompensationDelta(float DeltaTime, float CurrentRecoil);
+	float calculateRecoilCompensationDelta(float DeltaTime, float CurrentRecoil, float Modifier);
 	float getDamageMultiplierFor(EPhysicalSurface SurfaceType);
 	void buildDamageCurve();
 	void updateSingleBulletReloadTime();
 
+	//counts the kills of the owner while the weapon is equipped
+	UFUNCTION()
+	void onActorKilled(AActor* VictimActor, AActor* KillerActor, AController* KillerController);
+
 public:
 	UPROPERTY(BlueprintAssignable, Category = "Weapon|Events")
 	FOnAmmoChangedEvent OnAmmoChangedEvent;
@@ -259,7 +279,8 @@ protected:
 	//derived
 	float timeBetweenShots = 0;
 	float singleBulletReloadTime = 0;
-	FRuntimeFloatCurve damageCurve;
+	FDamageFalloff damageFalloff;
+	FWeaponRandomStream randomStream;
 
 	AShooterCharacter* owningCharacter;
 	bool bIsAmmoLeftInMagazine = true;
@@ -269,10 +290,14 @@ protected:
 	float lastFireTime = 0;
 	float timeEquipped = 0;
 
-	FTimerHandle timerHandle_AutomaticFire;
-	FTimerHandle timerHandle_ReloadMagazine;
-	FTimerHandle timerHandle_ReloadStock;
-	FTimerHandle timerHandle_SpreadDecrease;
+	//fire, reload and spread decrease are scheduled by world time and handled in Tick
+	bool bWantsToFire = false;
+	float nextShotTime = 0;
+	bool bIsReloadingMagazine = false;
+	float reloadFinishTime = 0;
+	bool bIsSpreadDecreasing = false;
+	float nextSpreadDecreaseTime = 0;
 
 	FWeaponStatistics statistics;
+	TWeakObjectPtr<AShooterEffectPool> effectPool;
 };
@@ -0,0 +1,91 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "ShooterWeaponPool.h"
+#include "ShooterWeapon.h"
+#include "Engine/World.h"
+#include "ChangingGuns.h"
+
+AShooterWeaponPool::AShooterWeaponPool()
+{
+	PrimaryActorTick.bCanEverTick = false;
+}
+
+AShooterWeaponPool* AShooterWeaponPool::Get(UWorld* World)
+{
+	return TWorldSingleton<AShooterWeaponPool>::Get(World);
+}
+
+AShooterWeapon* AShooterWeaponPool::AcquireWeapon(TSubclassOf<AShooterWeapon> WeaponClass, const FTransform& Transform)
+{
+	if (!WeaponClass.GetDefaultObject())
+		return nullptr;
+
+	if (FPooledShooterWeapons* pool = pooledWeapons.Find(*WeaponClass))
+	{
+		while (pool->Weapons.Num() > 0)
+		{
+			AShooterWeapon* weapon = pool->Weapons.Pop(false);
+			if (!weapon || weapon->IsPendingKill())
+				continue;
+
+			//the weapon has already been reset when it was released
+			weapon->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+			weapon->SetActorHiddenInGame(false);
+			weapon->SetActorEnableCollision(true);
+			return weapon;
+		}
+	}
+
+	return spawnWeapon(WeaponClass, Transform);
+}
+
+void AShooterWeaponPool::ReleaseWeapon(AShooterWeapon* Weapon)
+{
+	if (!Weapon || Weapon->IsPendingKill())
+		return;
+
+	FPooledShooterWeapons& pool = pooledWeapons.FindOrAdd(Weapon->GetClass());
+	if (pool.Weapons.Contains(Weapon))
+		return;
+
+	if (pool.Weapons.Num() >= maxPooledWeaponsPerClass)
+	{
+		Weapon->Destroy();
+		return;
+	}
+
+	//a dead character could have set a life span on it
+	Weapon->SetLifeSpan(0.f);
+	Weapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	Weapon->SetOwner(nullptr);
+	Weapon->ResetForReuse();
+	Weapon->SetActorHiddenInGame(true);
+	Weapon->SetActorEnableCollision(false);
+	pool.Weapons.Add(Weapon);
+}
+
+void AShooterWeaponPool::Prewarm(TSubclassOf<AShooterWeapon> WeaponClass, int32 NumWeapons)
+{
+	if (!WeaponClass.GetDefaultObject())
+		return;
+
+	FPooledShooterWeapons& pool = pooledWeapons.FindOrAdd(*WeaponClass);
+	const int32 numToSpawn = FMath::Min(NumWeapons, maxPooledWeaponsPerClass) - pool.Weapons.Num();
+	for (int32 i = 0; i < numToSpawn; ++i)
+	{
+		AShooterWeapon* weapon = spawnWeapon(WeaponClass, GetActorTransform());
+		if (!weapon)
+			return;
+
+		weapon->SetActorHiddenInGame(true);
+		weapon->SetActorEnableCollision(false);
+		pool.Weapons.Add(weapon);
+	}
+}
+
+AShooterWeapon* AShooterWeaponPool::spawnWeapon(TSubclassOf<AShooterWeapon> WeaponClass, const FTransform& Transform)
+{
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AShooterWeapon>(WeaponClass, Transform, spawnParams);
+}
@@ -0,0 +1,54 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ShooterWeaponPool.generated.h"
+
+class AShooterWeapon;
+
+USTRUCT()
+struct FPooledShooterWeapons
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<AShooterWeapon*> Weapons;
+};
+
+/**
+ * Keeps released weapons per weapon class and hands them out again instead of spawning new ones,
+ * so generating, equipping and dropping weapons doesn't cause spawn/destroy hitches and garbage collection churn.
+ */
+UCLASS(NotBlueprintable)
+class THESISPROTOTYPE_API AShooterWeaponPool : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AShooterWeaponPool();
+
+	//see TWorldSingleton
+	static AShooterWeaponPool* Get(UWorld* World);
+
+	//returns a pooled weapon reset to the class defaults or spawns a new one if the pool is empty
+	AShooterWeapon* AcquireWeapon(TSubclassOf<AShooterWeapon> WeaponClass, const FTransform& Transform);
+
+	//detaches and hides the weapon and keeps it for the next AcquireWeapon, the caller must not use it anymore
+	void ReleaseWeapon(AShooterWeapon* Weapon);
+
+	//spawns weapons up front, e.g., for every weapon class the generator can create
+	void Prewarm(TSubclassOf<AShooterWeapon> WeaponClass, int32 NumWeapons);
+
+protected:
+	AShooterWeapon* spawnWeapon(TSubclassOf<AShooterWeapon> WeaponClass, const FTransform& Transform);
+
+protected:
+	//released weapons above this amount per class are destroyed
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Pool")
+	int32 maxPooledWeaponsPerClass = 16;
+
+	UPROPERTY(Transient)
+	TMap<UClass*, FPooledShooterWeapons> pooledWeapons;
+};
@@ -0,0 +1,299 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "WeaponBenchmark.h"
+#include "ShooterWeaponPool.h"
+#include "Components/BoxComponent.h"
+#include "Components/HealthComponent.h"
+#include "Pawns/ShooterCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Dom/JsonObject.h"
+
+AWeaponBenchmarkTarget::AWeaponBenchmarkTarget()
+{
+	boxComp = CreateDefaultSubobject<UBoxComponent>(TEXT("BoxComp"));
+	boxComp->SetBoxExtent(FVector(40.f, 40.f, 60.f));
+	boxComp->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	boxComp->SetCollisionResponseToAllChannels(ECR_Ignore);
+	boxComp->SetCollisionResponseToChannel(COLLISION_WEAPON, ECR_Block);
+	RootComponent = boxComp;
+
+	//the default team of the health component is the bot team
+	healthComp = CreateDefaultSubobject<UHealthComponent>(TEXT("HealthComp"));
+}
+
+float AWeaponBenchmarkTarget::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const uint64 startCycles = FPlatformTime::Cycles64();
+	const float damage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+	damageCycles += FPlatformTime::Cycles64() - startCycles;
+	++numDamageEvents;
+	return damage;
+}
+
+AWeaponBenchmark::AWeaponBenchmark()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	shooterClass = AShooterCharacter::StaticClass();
+}
+
+void AWeaponBenchmark::BeginPlay()
+{
+	Super::BeginPlay();
+
+	IConsoleVariable* weaponEffects = IConsoleManager::Get().FindConsoleVariable(TEXT("Game.WeaponEffects"));
+	previousWeaponEffects = weaponEffects->GetInt();
+	weaponEffects->Set(bPlayEffects ? 1 : 0, ECVF_SetByCode);
+	//the set is ignored if the variable has been set with a higher priority, e.g., in an ini file or on the command line
+	bEffectsEnabled = weaponEffects->GetInt() > 0;
+	if (bEffectsEnabled != bPlayEffects)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Weapon benchmark: Game.WeaponEffects has been set with a higher priority, the effects are %s"), bEffectsEnabled ? TEXT("on") : TEXT("off"));
+	}
+
+	spawnShooters();
+	targets.SetNumZeroed(FMath::Max(1, targetGridSize.X) * FMath::Max(1, targetGridSize.Y));
+	for (int32 i = 0; i < targets.Num(); ++i)
+	{
+		spawnTarget(i);
+	}
+
+	bIsRunning = true;
+	startTime = FPlatformTime::Seconds();
+	startWorldTime = GetWorld()->TimeSeconds;
+}
+
+void AWeaponBenchmark::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	stopBenchmark();
+
+	//the world takes everything else with it
+	if (EndPlayReason == EEndPlayReason::Destroyed)
+	{
+		if (AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(GetWorld()))
+		{
+			for (AShooterWeapon* weapon : weapons)
+			{
+				weaponPool->ReleaseWeapon(weapon);
+			}
+		}
+		for (AShooterCharacter* shooter : shooters)
+		{
+			shooter->Destroy();
+		}
+		for (AWeaponBenchmarkTarget* target : targets)
+		{
+			if (target)
+			{
+				target->Destroy();
+			}
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AWeaponBenchmark::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsRunning)
+		return;
+
+	++numFrames;
+
+	//the damage of the last frame has been applied at its end
+	for (int32 i = 0; i < targets.Num(); ++i)
+	{
+		if (targets[i] && targets[i]->GetHealthComponent()->GetHealth() > 0.f)
+			continue;
+
+		if (targets[i])
+		{
+			destroyTarget(i);
+			++numKilledTargets;
+		}
+		spawnTarget(i);
+	}
+
+	//semi automatic and single fire weapons stop after every shot
+	for (AShooterWeapon* weapon : weapons)
+	{
+		if (bFireWeapons && !weapon->IsFiring())
+		{
+			weapon->StartFire();
+		}
+	}
+
+	if (duration > 0.f && GetWorld()->TimeSeconds - startWorldTime >= duration)
+	{
+		stopBenchmark();
+		LogResults();
+	}
+}
+
+void AWeaponBenchmark::spawnShooters()
+{
+	TArray<TSubclassOf<AShooterWeapon>> classes = weaponClasses;
+	classes.RemoveAll([](const TSubclassOf<AShooterWeapon>& WeaponClass) { return !WeaponClass; });
+	if (classes.Num() == 0)
+	{
+		classes.Add(AShooterWeapon::StaticClass());
+	}
+
+	AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(GetWorld());
+	if (!weaponPool)
+		return;
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	spawnParams.Owner = this;
+
+	const FTransform& transform = GetActorTransform();
+	const int32 numShooters = classes.Num() * shootersPerWeaponClass;
+	for (int32 i = 0; i < numShooters; ++i)
+	{
+		//in a row across the firing line, every shooter faces the center of the target grid
+		const FVector location = transform.TransformPosition(FVector(0.f, (i - (numShooters - 1) * 0.5f) * shooterSpacing, 0.f));
+		const FRotator rotation(0.f, (transform.TransformPosition(FVector(targetDistance, 0.f, 0.f)) - location).Rotation().Yaw, 0.f);
+		AShooterCharacter* shooter = GetWorld()->SpawnActor<AShooterCharacter>(shooterClass ? shooterClass.Get() : AShooterCharacter::StaticClass(), location, rotation, spawnParams);
+		if (!shooter)
+			continue;
+
+		AShooterWeapon* weapon = weaponPool->AcquireWeapon(classes[i / shootersPerWeaponClass], shooter->GetActorTransform());
+		if (!weapon)
+		{
+			shooter->Destroy();
+			continue;
+		}
+
+		//there is no floor to stand on
+		shooter->GetCharacterMovement()->DisableMovement();
+
+		//the shooters would be friendly to the targets with the default team
+		if (UHealthComponent* healthComp = UHealthComponent::FindHealthComponent(shooter))
+		{
+			healthComp->SetTeamNumber(0);
+		}
+
+		weapon->SetOwner(shooter);
+		weapon->SetBulletsPerMagazine(MagazineSize);
+		weapon->Equip(shooter);
+
+		shooters.Add(shooter);
+		weapons.Add(weapon);
+	}
+}
+
+void AWeaponBenchmark::spawnTarget(int32 Index)
+{
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	spawnParams.Owner = this;
+	targets[Index] = GetWorld()->SpawnActor<AWeaponBenchmarkTarget>(getTargetLocation(Index), GetActorRotation(), spawnParams);
+}
+
+void AWeaponBenchmark::destroyTarget(int32 Index)
+{
+	numDamageEvents += targets[Index]->GetNumDamageEvents();
+	damageCycles += targets[Index]->GetDamageCycles();
+	targets[Index]->Destroy();
+	targets[Index] = nullptr;
+}
+
+FVector AWeaponBenchmark::getTargetLocation(int32 Index) const
+{
+	const FIntPoint gridSize(FMath::Max(1, targetGridSize.X), FMath::Max(1, targetGridSize.Y));
+	const FVector2D gridCell(Index % gridSize.X, Index / gridSize.X);
+	const FVector2D gridOffset = (gridCell - FVector2D(gridSize.X - 1, gridSize.Y - 1) * 0.5f) * targetSpacing;
+	return GetActorTransform().TransformPosition(FVector(targetDistance, gridOffset.X, gridOffset.Y));
+}
+
+void AWeaponBenchmark::stopBenchmark()
+{
+	if (!bIsRunning)
+		return;
+
+	bIsRunning = false;
+	stopTime = FPlatformTime::Seconds();
+	stopWorldTime = GetWorld()->TimeSeconds;
+
+	for (AShooterWeapon* weapon : weapons)
+	{
+		weapon->StopFire();
+	}
+
+	IConsoleManager::Get().FindConsoleVariable(TEXT("Game.WeaponEffects"))->Set(previousWeaponEffects, ECVF_SetByCode);
+}
+
+int64 AWeaponBenchmark::GetNumShots() const
+{
+	int64 shots = 0;
+	for (const AShooterWeapon* weapon : weapons)
+	{
+		shots += MagazineSize - weapon->GetCurrentBulletsInMagazine();
+	}
+	return shots;
+}
+
+int64 AWeaponBenchmark::GetNumTraces() const
+{
+	int64 traces = 0;
+	for (const AShooterWeapon* weapon : weapons)
+	{
+		traces += static_cast<int64>(MagazineSize - weapon->GetCurrentBulletsInMagazine()) * FMath::Max(1, weapon->GetBulletsInOneShot());
+	}
+	return traces;
+}
+
+TSharedRef<FJsonObject> AWeaponBenchmark::GetResults() const
+{
+	const double seconds = (bIsRunning ? FPlatformTime::Seconds() : stopTime) - startTime;
+	const float simulatedSeconds = (bIsRunning ? GetWorld()->TimeSeconds : stopWorldTime) - startWorldTime;
+	const double millisecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000.0;
+	auto perItem = [](double Value, double Num) { return Num > 0.0 ? Value / Num : 0.0; };
+
+	int64 damageEvents = numDamageEvents;
+	uint64 totalDamageCycles = damageCycles;
+	for (const AWeaponBenchmarkTarget* target : targets)
+	{
+		if (target)
+		{
+			damageEvents += target->GetNumDamageEvents();
+			totalDamageCycles += target->GetDamageCycles();
+		}
+	}
+	const double damageMilliseconds = totalDamageCycles * millisecondsPerCycle;
+	const int64 shots = GetNumShots();
+	const int64 traces = GetNumTraces();
+
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	json->SetNumberField(TEXT("shooters"), shooters.Num());
+	json->SetNumberField(TEXT("targets"), targets.Num());
+	json->SetBoolField(TEXT("effects"), bEffectsEnabled);
+	json->SetNumberField(TEXT("frames"), numFrames);
+	json->SetNumberField(TEXT("seconds"), seconds);
+	json->SetNumberField(TEXT("simulatedSeconds"), simulatedSeconds);
+	json->SetNumberField(TEXT("frameMs"), perItem(seconds * 1000.0, numFrames));
+	json->SetNumberField(TEXT("shots"), shots);
+	json->SetNumberField(TEXT("traces"), traces);
+	json->SetNumberField(TEXT("damageEvents"), damageEvents);
+	json->SetNumberField(TEXT("killedTargets"), numKilledTargets);
+	json->SetNumberField(TEXT("tracesPerSecond"), perItem(traces, seconds));
+	//the whole frame, so it includes the effects and the damage
+	json->SetNumberField(TEXT("frameUsPerTrace"), perItem(seconds * 1000.0 * 1000.0, traces));
+	json->SetNumberField(TEXT("damageMsPerFrame"), perItem(damageMilliseconds, numFrames));
+	json->SetNumberField(TEXT("damageUsPerEvent"), perItem(damageMilliseconds * 1000.0, damageEvents));
+	return json;
+}
+
+void AWeaponBenchmark::LogResults() const
+{
+	const TSharedRef<FJsonObject> results = GetResults();
+	UE_LOG(LogTemp, Display, TEXT("Weapon benchmark (%d shooters, %d targets, effects %s, %d frames): %.2f ms/frame, %.0f traces/s, %.2f us/trace, damage %.2f us/event, %d killed targets"),
+		shooters.Num(), targets.Num(), bEffectsEnabled ? TEXT("on") : TEXT("off"), numFrames, results->GetNumberField(TEXT("frameMs")), results->GetNumberField(TEXT("tracesPerSecond")),
+		results->GetNumberField(TEXT("frameUsPerTrace")), results->GetNumberField(TEXT("damageUsPerEvent")), numKilledTargets);
+}
@@ -0,0 +1,152 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ShooterWeapon.h"
+#include "ChangingGuns.h"
+#include "WeaponBenchmark.generated.h"
+
+class UBoxComponent;
+class UHealthComponent;
+class AShooterCharacter;
+class FJsonObject;
+
+/**
+ * Box which blocks weapon traces and takes damage like a bot, the weapon benchmark replaces it once it is killed.
+ */
+UCLASS(NotBlueprintable)
+class THESISPROTOTYPE_API AWeaponBenchmarkTarget : public AActor
+{
+	GENERATED_BODY()
+
+protected:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UBoxComponent* boxComp;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+	UHealthComponent* healthComp;
+
+public:
+	AWeaponBenchmarkTarget();
+
+	//counts and times the damage path, i.e., ApplyPointDamage -> handleTakeAnyDamage
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
+
+	FORCEINLINE UHealthComponent* GetHealthComponent() const { return healthComp; }
+	FORCEINLINE int32 GetNumDamageEvents() const { return numDamageEvents; }
+	FORCEINLINE uint64 GetDamageCycles() const { return damageCycles; }
+
+protected:
+	int32 numDamageEvents = 0;
+	uint64 damageCycles = 0;
+};
+
+/**
+ * Load test of the hit scan path (fire -> ApplyPointDamage -> handleTakeAnyDamage) which doesn't need a renderer.
+ * Spawns shootersPerWeaponClass shooters for every weapon class which fire continuously from one huge magazine at a grid of targets.
+ * It measures the frame time per trace and the damage path at the targets, the effects can be disabled (Game.WeaponEffects)
+ * and the shooters can hold their fire, the WeaponBenchmark commandlet derives the cost of fire and effects from these passes.
+ * The fire, damage and effect cycles of the weapons are in 'stat ChangingGuns' as well.
+ * Place it in an empty map or run the WeaponBenchmark commandlet, e.g., with -nullrhi.
+ */
+UCLASS()
+class THESISPROTOTYPE_API AWeaponBenchmark : public AActor
+{
+	GENERATED_BODY()
+
+	//configures the benchmark before it begins play
+	friend class UWeaponBenchmarkCommandlet;
+
+protected:
+	//AShooterWeapon if empty
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark")
+	TArray<TSubclassOf<AShooterWeapon>> weaponClasses;
+
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark")
+	TSubclassOf<AShooterCharacter> shooterClass;
+
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark", meta = (ClampMin = 1))
+	int32 shootersPerWeaponClass = 4;
+
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark", meta = (ClampMin = 1.0))
+	float shooterSpacing = 100.f;
+
+	//targets in y and z
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark")
+	FIntPoint targetGridSize = FIntPoint(8, 8);
+
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark", meta = (ClampMin = 1.0))
+	float targetSpacing = 150.f;
+
+	//from the shooters to the target grid
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark", meta = (ClampMin = 1.0))
+	float targetDistance = 20.f * PROJECT_MEASURING_UNIT_FACTOR_TO_M;
+
+	//the shooters hold their fire, so the frame time is the cost of everything besides firing
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark")
+	bool bFireWeapons = true;
+
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark")
+	bool bPlayEffects = true;
+
+	//the results are logged after this many seconds, 0 runs until the benchmark is destroyed
+	UPROPERTY(EditAnywhere, Category = "Weapon Benchmark", meta = (ClampMin = 0.0))
+	float duration = 60.f;
+
+public:
+	AWeaponBenchmark();
+
+	virtual void Tick(float DeltaTime) override;
+
+	//collected since the benchmark began play
+	TSharedRef<FJsonObject> GetResults() const;
+	void LogResults() const;
+
+	//counted by the bullets spent from the magazines
+	int64 GetNumShots() const;
+	int64 GetNumTraces() const;
+	FORCEINLINE int32 GetNumFrames() const { return numFrames; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void spawnShooters();
+	void spawnTarget(int32 Index);
+	FVector getTargetLocation(int32 Index) const;
+	//the counters of the killed targets are kept
+	void destroyTarget(int32 Index);
+	//stops the collection and restores Game.WeaponEffects
+	void stopBenchmark();
+
+	//never runs empty, so no shooter has to reload
+	static const int32 MagazineSize = 1000 * 1000;
+
+protected:
+	UPROPERTY(Transient)
+	TArray<AShooterCharacter*> shooters;
+
+	//in the order of shooters
+	UPROPERTY(Transient)
+	TArray<AShooterWeapon*> weapons;
+
+	//in the order of the grid
+	UPROPERTY(Transient)
+	TArray<AWeaponBenchmarkTarget*> targets;
+
+	//of the destroyed targets
+	int64 numDamageEvents = 0;
+	uint64 damageCycles = 0;
+	bool bIsRunning = false;
+	//Game.WeaponEffects while the benchmark runs, which differs from bPlayEffects if it has been set with a higher priority
+	bool bEffectsEnabled = true;
+	double startTime = 0.0;
+	double stopTime = 0.0;
+	float startWorldTime = 0.f;
+	float stopWorldTime = 0.f;
+	int32 numFrames = 0;
+	int32 numKilledTargets = 0;
+	int32 previousWeaponEffects = 1;
+};
@@ -0,0 +1,65 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "WeaponFeatureVector.h"
+#include "ShooterWeapon.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+
+const TCHAR* const FWeaponFeatureVector::FeatureNames[FWeaponFeatureVector::NumFeatures] =
+{
+	TEXT("damages_first"),
+	TEXT("damages_last"),
+	TEXT("distances_last"),
+	TEXT("rof"),
+	TEXT("magsize"),
+	TEXT("reloadempty"),
+	TEXT("shotspershell"),
+	TEXT("hiprecoilright"),
+	TEXT("hiprecoilup"),
+	TEXT("distances_first"),
+	TEXT("initialspeed"),
+	TEXT("hiprecoildec"),
+	TEXT("hipstandbasespreaddec"),
+	TEXT("hipstandbasespreadinc"),
+	TEXT("type_Shotgun"),
+	TEXT("type_Pistol"),
+	TEXT("type_Rifle"),
+	TEXT("type_SMG"),
+	TEXT("type_Sniper"),
+	TEXT("type_MG"),
+	TEXT("firemode_Automatic"),
+	TEXT("firemode_Semi"),
+	TEXT("firemode_Single")
+};
+
+void FWeaponFeatureVector::SetWeaponType(EWeaponType WeaponType)
+{
+	(*this)[EWeaponFeature::TypeShotgun] = WeaponType == EWeaponType::Shotgun ? 1.f : 0.f;
+	(*this)[EWeaponFeature::TypePistol] = WeaponType == EWeaponType::Pistol ? 1.f : 0.f;
+	(*this)[EWeaponFeature::TypeRifle] = WeaponType == EWeaponType::Rifle ? 1.f : 0.f;
+	(*this)[EWeaponFeature::TypeSMG] = WeaponType == EWeaponType::SubMachineGun ? 1.f : 0.f;
+	(*this)[EWeaponFeature::TypeSniper] = WeaponType == EWeaponType::SniperRifle ? 1.f : 0.f;
+	(*this)[EWeaponFeature::TypeMG] = WeaponType == EWeaponType::HeavyMachineGun ? 1.f : 0.f;
+}
+
+void FWeaponFeatureVector::SetFireMode(EFireMode FireMode)
+{
+	(*this)[EWeaponFeature::FireModeAutomatic] = FireMode == EFireMode::Automatic ? 1.f : 0.f;
+	(*this)[EWeaponFeature::FireModeSemi] = FireMode == EFireMode::SemiAutomatic ? 1.f : 0.f;
+	(*this)[EWeaponFeature::FireModeSingle] = FireMode == EFireMode::SingleFire ? 1.f : 0.f;
+}
+
+FString FWeaponFeatureVector::ToJsonString() const
+{
+	TSharedRef<FJsonObject> json = MakeShared<FJsonObject>();
+	for (int32 i = 0; i < NumFeatures; ++i)
+	{
+		json->SetNumberField(FeatureNames[i], Values[i]);
+	}
+
+	FString jsonString;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&jsonString);
+	FJsonSerializer::Serialize(json, writer);
+	return jsonString;
+}
@@ -0,0 +1,71 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EWeaponType : uint8;
+enum class EFireMode : uint8;
+
+//weapon_data.NUMERICAL_PARAMS followed by the one hot encoded WEAPON_TYPES and WEAPON_FIREMODES (see weapon_data.ENCODED_FEATURE_NAMES)
+enum class EWeaponFeature : uint8
+{
+	DamagesFirst,
+	DamagesLast,
+	//in meters
+	DistancesLast,
+	RateOfFire,
+	MagazineSize,
+	ReloadEmpty,
+	ShotsPerShell,
+	HipRecoilRight,
+	HipRecoilUp,
+	//in meters
+	DistancesFirst,
+	InitialSpeed,
+	HipRecoilDecrease,
+	HipSpreadDecrease,
+	HipSpreadIncrease,
+	TypeShotgun,
+	TypePistol,
+	TypeRifle,
+	TypeSMG,
+	TypeSniper,
+	TypeMG,
+	FireModeAutomatic,
+	FireModeSemi,
+	FireModeSingle,
+	Num
+};
+
+/**
+ * Plain float representation of a weapon as the weapon generator sees it.
+ * Used end to end by the generator, so a dismantle doesn't allocate or parse any strings.
+ */
+struct THESISPROTOTYPE_API FWeaponFeatureVector
+{
+	static const int32 NumFeatures = static_cast<int32>(EWeaponFeature::Num);
+
+	//column names of the features like in the training data, e.g., 'rof' or 'type_Pistol'
+	static const TCHAR* const FeatureNames[NumFeatures];
+
+	float Values[NumFeatures];
+
+	FWeaponFeatureVector()
+	{
+		FMemory::Memzero(Values);
+	}
+
+	FORCEINLINE float& operator[](EWeaponFeature Feature) { return Values[static_cast<int32>(Feature)]; }
+	FORCEINLINE float operator[](EWeaponFeature Feature) const { return Values[static_cast<int32>(Feature)]; }
+
+	//one hot encodes the type and the fire mode
+	void SetWeaponType(EWeaponType WeaponType);
+	void SetFireMode(EFireMode FireMode);
+
+	//only for debugging, e.g., to compare the features with the training data
+	FString ToJsonString() const;
+};
+
+//batches of feature vectors are passed to the VAE as one float matrix
+static_assert(sizeof(FWeaponFeatureVector) == FWeaponFeatureVector::NumFeatures * sizeof(float), "FWeaponFeatureVector must not have any padding!");
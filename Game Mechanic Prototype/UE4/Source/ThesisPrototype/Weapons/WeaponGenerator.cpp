@@ -2,79 +2,61 @@
 
 #include "WeaponGenerator.h"
 #include "ShooterWeapon.h"
+#include "WeaponGeneratorVAE.h"
+#include "ShooterWeaponPool.h"
+#include "WeaponFeatureVector.h"
 #include "Engine/World.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "Async/Async.h"
 #include "ChangingGuns.h"
 
-FWeaponGeneratorAPIJsonData::FWeaponGeneratorAPIJsonData(FVector2D MaxDamageWithDistance, FVector2D MinDamageWithDistance, EWeaponType WeaponType,
-	EFireMode FireMode, FVector2D RecoilIncreasePerShot, float RecoilDecrease, float BulletSpreadIncrease, float BulletSpreadDecrease, int32 RateOfFire,
-	int32 BulletsPerMagazine, float ReloadTimeEmptyMagazine, int32 BulletsInOneShot, int32 MuzzleVelocity)
+//json data fields in the order of the feature vector
+static FString FWeaponGeneratorAPIJsonData::* const JsonDataFeatureFields[FWeaponFeatureVector::NumFeatures] =
 {
-	damages_first = FString::SanitizeFloat(MaxDamageWithDistance.X, 4);
-	damages_last = FString::SanitizeFloat(MinDamageWithDistance.X, 4) ;
-	distances_first = FString::SanitizeFloat(MaxDamageWithDistance.Y / PROJECT_MEASURING_UNIT_FACTOR_TO_M, 4);
-	distances_last = FString::SanitizeFloat(MinDamageWithDistance.Y / PROJECT_MEASURING_UNIT_FACTOR_TO_M, 4);
-
-	hiprecoildec = FString::SanitizeFloat(RecoilDecrease, 4);
-	hiprecoilright = FString::SanitizeFloat(RecoilIncreasePerShot.X, 4);
-	hiprecoilup = FString::SanitizeFloat(RecoilIncreasePerShot.Y, 4);
-	hipstandbasespreaddec = FString::SanitizeFloat(BulletSpreadDecrease, 4);
-	hipstandbasespreadinc = FString::SanitizeFloat(BulletSpreadIncrease, 4);
-	magsize = FString::FromInt(BulletsPerMagazine);
-	reloadempty = FString::SanitizeFloat(ReloadTimeEmptyMagazine, 4);
-	rof = FString::FromInt(RateOfFire);
-	shotspershell = FString::FromInt(BulletsInOneShot);
-	initial_speed = FString::FromInt(MuzzleVelocity);
-
-
-	//categorical one hot encoding
-	const FString zero = "0";
-	const FString one = "1";
-
-	firemode_Automatic = zero;
-	firemode_Semi = zero;
-	firemode_Single = zero;
-	switch(FireMode)
+	&FWeaponGeneratorAPIJsonData::damages_first,
+	&FWeaponGeneratorAPIJsonData::damages_last,
+	&FWeaponGeneratorAPIJsonData::distances_last,
+	&FWeaponGeneratorAPIJsonData::rof,
+	&FWeaponGeneratorAPIJsonData::magsize,
+	&FWeaponGeneratorAPIJsonData::reloadempty,
+	&FWeaponGeneratorAPIJsonData::shotspershell,
+	&FWeaponGeneratorAPIJsonData::hiprecoilright,
+	&FWeaponGeneratorAPIJsonData::hiprecoilup,
+	&FWeaponGeneratorAPIJsonData::distances_first,
+	&FWeaponGeneratorAPIJsonData::initial_speed,
+	&FWeaponGeneratorAPIJsonData::hiprecoildec,
+	&FWeaponGeneratorAPIJsonData::hipstandbasespreaddec,
+	&FWeaponGeneratorAPIJsonData::hipstandbasespreadinc,
+	&FWeaponGeneratorAPIJsonData::type_Shotgun,
+	&FWeaponGeneratorAPIJsonData::type_Pistol,
+	&FWeaponGeneratorAPIJsonData::type_Rifle,
+	&FWeaponGeneratorAPIJsonData::type_SMG,
+	&FWeaponGeneratorAPIJsonData::type_Sniper,
+	&FWeaponGeneratorAPIJsonData::type_MG,
+	&FWeaponGeneratorAPIJsonData::firemode_Automatic,
+	&FWeaponGeneratorAPIJsonData::firemode_Semi,
+	&FWeaponGeneratorAPIJsonData::firemode_Single
+};
+
+FWeaponGeneratorAPIJsonData FWeaponGeneratorAPIJsonData::FromFeatureVector(const FWeaponFeatureVector& Features)
+{
+	FWeaponGeneratorAPIJsonData jsonData;
+	for (int32 i = 0; i < FWeaponFeatureVector::NumFeatures; ++i)
 	{
-		case EFireMode::Automatic:
-			firemode_Automatic = one;
-			break;
-		case EFireMode::SemiAutomatic:
-			firemode_Semi = one;
-			break;
-		case EFireMode::SingleFire:
-			firemode_Single = one;
-			break;
+		jsonData.*JsonDataFeatureFields[i] = FString::SanitizeFloat(Features.Values[i], 4);
 	}
+	return jsonData;
+}
 
-	type_Pistol = zero;
-	type_Rifle = zero;
-	type_Shotgun = zero;
-	type_Sniper = zero;
-	type_SMG = zero;
-	type_MG = zero;
-
-	switch(WeaponType)
+FWeaponFeatureVector FWeaponGeneratorAPIJsonData::ToFeatureVector() const
+{
+	FWeaponFeatureVector features;
+	for (int32 i = 0; i < FWeaponFeatureVector::NumFeatures; ++i)
 	{
-		case EWeaponType::Pistol:
-			type_Pistol = one;
-			break;
-		case EWeaponType::Shotgun:
-			type_Shotgun = one;
-			break;
-		case EWeaponType::SubMachineGun:
-			type_SMG = one;
-			break;
-		case EWeaponType::Rifle:
-			type_Rifle = one;
-			break;
-		case EWeaponType::SniperRifle:
-			type_Sniper = one;
-			break;
-		case EWeaponType::HeavyMachineGun:
-			type_MG = one;
-			break;
+		features.Values[i] = FCString::Atof(*(this->*JsonDataFeatureFields[i]));
 	}
-	success = "hopefully :P";
+	return features;
 }
 
 AWeaponGenerator::AWeaponGenerator()
@@ -86,11 +68,377 @@ AWeaponGenerator::AWeaponGenerator()
 	offsetPerMinuteUsed = 0.1f;
 }
 
-void AWeaponGenerator::DismantleWeapon(AShooterWeapon* Weapon)
+void AWeaponGenerator::BeginPlay()
+{
+	Super::BeginPlay();
+
+	randomNumberGenerator.Initialize(FSessionSeed::NextStreamSeed(TEXT("WeaponGenerator")));
+
+	if (AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(GetWorld()))
+	{
+		for (const TSubclassOf<AShooterWeapon>& weaponClass : { pistolClass, sniperClass, machineGunClass, rifleClass, smgClass, shotgunClass })
+		{
+			weaponPool->Prewarm(weaponClass, pooledWeaponsPerClass);
+		}
+	}
+
+	if (bUseNativeInference && loadNativeModel())
+	{
+		setReadyToUse(true);
+	}
+}
+
+bool AWeaponGenerator::loadNativeModel()
+{
+	//the export replaces the model file instead of rewriting it, so the current mapping stays valid and the new file is mapped here
+	FDateTime modelTimeStamp;
+	const FString modelFile = findNativeModelFile(modelTimeStamp);
+	if (nativeVAE.IsValid() && modelFile == loadedNativeModelFile && modelTimeStamp == loadedNativeModelTimeStamp)
+		return true;
+
+	TSharedPtr<FWeaponGeneratorVAE, ESPMode::ThreadSafe> vae = MakeShared<FWeaponGeneratorVAE, ESPMode::ThreadSafe>();
+	if (!vae->LoadFromFile(modelFile))
+	{
+		//keep the previous model if there is one
+		return nativeVAE.IsValid();
+	}
+	nativeVAE = vae;
+	loadedNativeModelFile = modelFile;
+	loadedNativeModelTimeStamp = modelTimeStamp;
+	++nativeModelGeneration;
+
+	//the prefetched weapons are from the previous model, a running refill is restarted once it finished
+	for (TArray<FWeaponFeatureVector>& pool : prefetchPool)
+	{
+		pool.Reset();
+	}
+	refillPrefetchPool();
+	return true;
+}
+
+FString AWeaponGenerator::findNativeModelFile(FDateTime& OutTimeStamp) const
+{
+	//windows can't replace a mapped file, so the export falls back to a new version next to it, e.g., model.1.wvae
+	IFileManager& fileManager = IFileManager::Get();
+	const FString modelFile = FPaths::ProjectContentDir() / nativeModelFile;
+	const FString directory = FPaths::GetPath(modelFile);
+	TArray<FString> versionedFiles;
+	fileManager.FindFiles(versionedFiles, *(directory / FPaths::GetBaseFilename(modelFile) + TEXT(".*") + FPaths::GetExtension(modelFile, true)), true, false);
+
+	FString newestFile = modelFile;
+	OutTimeStamp = fileManager.GetTimeStamp(*modelFile);
+	for (const FString& versionedFile : versionedFiles)
+	{
+		const FDateTime timeStamp = fileManager.GetTimeStamp(*(directory / versionedFile));
+		if (timeStamp > OutTimeStamp)
+		{
+			newestFile = directory / versionedFile;
+			OutTimeStamp = timeStamp;
+		}
+	}
+	return newestFile;
+}
+
+int32 AWeaponGenerator::DismantleWeapon(AShooterWeapon* Weapon)
+{
+	int32 requestId = INDEX_NONE;
+	dismantleWeapons(&Weapon, 1, &requestId);
+	return requestId;
+}
+
+TArray<int32> AWeaponGenerator::DismantleWeapons(const TArray<AShooterWeapon*>& Weapons)
+{
+	TArray<int32> requestIds;
+	requestIds.SetNumUninitialized(Weapons.Num());
+	dismantleWeapons(Weapons.GetData(), Weapons.Num(), requestIds.GetData());
+	return requestIds;
+}
+
+void AWeaponGenerator::dismantleWeapons(AShooterWeapon* const* Weapons, int32 NumWeapons, int32* OutRequestIds)
+{
+	const bool bUsesPlugin = !bUseNativeInference || !nativeVAE.IsValid();
+
+	//all weapons which aren't served by the prefetch pool are generated with one inference call
+	TArray<FWeaponFeatureVector, TInlineAllocator<1>> weaponsToGenerate;
+	TArray<int32, TInlineAllocator<1>> requestIdsToGenerate;
+
+	for (int32 i = 0; i < NumWeapons; ++i)
+	{
+		AShooterWeapon* weapon = Weapons[i];
+		OutRequestIds[i] = INDEX_NONE;
+		if (!weapon || !bIsReadyToUse)
+			continue;
+
+		OnStartedWeaponGeneratorEvent.Broadcast();
+
+		FGenerationRequest& request = pendingRequests[pendingRequests.AddDefaulted()];
+		request.RequestId = nextRequestId++;
+		request.bUsesPlugin = bUsesPlugin;
+		request.bIsFinished = false;
+		request.bSucceeded = false;
+		request.DismantledWeapon = convertWeaponToFeatures(weapon);
+		OutRequestIds[i] = request.RequestId;
+		UE_LOG(LogTemp, Verbose, TEXT("Dismantled weapon (request %i): %s"), request.RequestId, *request.DismantledWeapon.ToJsonString());
+
+		if (bUsesPlugin)
+			continue;
+
+		//which weapons are in the pool depends on how fast the background threads are
+		if (prefetchedWeaponsPerType > 0 && !FSessionSeed::IsDeterministic())
+		{
+			//the dismantled weapon still influences the pool, just not the weapon which is returned right now
+			if (dismantledWeaponsToPrefetch.Num() < prefetchedWeaponsPerType * NumWeaponTypes)
+			{
+				dismantledWeaponsToPrefetch.Add(request.DismantledWeapon);
+			}
+
+			TArray<FWeaponFeatureVector>& pool = prefetchPool[static_cast<int32>(weapon->GetType())];
+			if (pool.Num() > 0)
+			{
+				request.GeneratedWeapon = pool.Pop(false);
+				request.bSucceeded = true;
+				request.bIsFinished = true;
+				continue;
+			}
+		}
+
+		weaponsToGenerate.Add(request.DismantledWeapon);
+		requestIdsToGenerate.Add(request.RequestId);
+	}
+
+	if (bUsesPlugin)
+	{
+		sendNextRequestToPlugin();
+		return;
+	}
+
+	if (weaponsToGenerate.Num() > 0)
+	{
+		//everything the job needs is copied, the generator could be gone when it finishes
+		TSharedPtr<const FWeaponGeneratorVAE, ESPMode::ThreadSafe> vae = nativeVAE;
+		const int32 numSamples = latentSamplesPerWeapon > 0 ? latentSamplesPerWeapon : vae->GetTrainedBatchSize();
+		const float costThreshold = randomWeaponCostThreshold;
+		const int32 randomSeed = randomNumberGenerator.RandHelper(MAX_int32);
+		TWeakObjectPtr<AWeaponGenerator> weakThis(this);
+
+		if (FSessionSeed::IsDeterministic())
+		{
+			//the weapons are finished in this frame instead of whenever the background job is done
+			FRandomStream randomStream(randomSeed);
+			TArray<FWeaponFeatureVector, TInlineAllocator<1>> generatedWeapons;
+			generatedWeapons.SetNum(weaponsToGenerate.Num());
+			generateNatively(*vae, weaponsToGenerate.GetData(), generatedWeapons.GetData(), weaponsToGenerate.Num(), numSamples, costThreshold, randomStream);
+			for (int32 i = 0; i < requestIdsToGenerate.Num(); ++i)
+			{
+				onGenerationRequestFinished(requestIdsToGenerate[i], true, generatedWeapons[i]);
+			}
+		}
+		else
+		{
+			AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [vae, weaponsToGenerate, requestIdsToGenerate, numSamples, costThreshold, randomSeed, weakThis]()
+			{
+				FRandomStream randomStream(randomSeed);
+				TArray<FWeaponFeatureVector, TInlineAllocator<1>> generatedWeapons;
+				generatedWeapons.SetNum(weaponsToGenerate.Num());
+				generateNatively(*vae, weaponsToGenerate.GetData(), generatedWeapons.GetData(), weaponsToGenerate.Num(), numSamples, costThreshold, randomStream);
+
+				AsyncTask(ENamedThreads::GameThread, [weakThis, requestIdsToGenerate, generatedWeapons]()
+				{
+					if (AWeaponGenerator* generator = weakThis.Get())
+					{
+						for (int32 i = 0; i < requestIdsToGenerate.Num(); ++i)
+						{
+							generator->onGenerationRequestFinished(requestIdsToGenerate[i], true, generatedWeapons[i]);
+						}
+					}
+				});
+			});
+		}
+	}
+
+	refillPrefetchPool();
+	finishCompletedRequests();
+}
+
+void AWeaponGenerator::generateNatively(const FWeaponGeneratorVAE& VAE, const FWeaponFeatureVector* DismantledWeapons, FWeaponFeatureVector* GeneratedWeapons, int32 NumWeapons,
+	int32 NumSamples, float RandomWeaponCostThreshold, FRandomStream& RandomStream)
+{
+	TArray<float, TInlineAllocator<1>> generationCosts;
+	generationCosts.SetNumUninitialized(NumWeapons);
+	VAE.EncodeAndDecodeBatch(DismantledWeapons->Values, GeneratedWeapons->Values, NumWeapons, NumSamples, RandomStream, generationCosts.GetData());
+
+	//same check as the TensorFlow plugin: a too high cost means that the VAE doesn't know which weapon that should be
+	TArray<int32, TInlineAllocator<1>> unknownWeapons;
+	for (int32 i = 0; i < NumWeapons; ++i)
+	{
+		const float generationCost = generationCosts[i] / VAE.GetTrainedBatchSize();
+		if (generationCost >= RandomWeaponCostThreshold || FMath::IsNaN(generationCost) || !FMath::IsFinite(generationCost))
+		{
+			unknownWeapons.Add(i);
+		}
+	}
+
+	if (unknownWeapons.Num() > 0)
+	{
+		//so generate random ones instead
+		TArray<float, TInlineAllocator<16>> z;
+		TArray<FWeaponFeatureVector, TInlineAllocator<1>> randomWeapons;
+		z.SetNumUninitialized(unknownWeapons.Num() * VAE.GetLatentDimension());
+		randomWeapons.SetNumUninitialized(unknownWeapons.Num());
+		VAE.SampleLatentSpace(z.GetData(), RandomStream, unknownWeapons.Num());
+		VAE.DecodeBatch(z.GetData(), randomWeapons[0].Values, unknownWeapons.Num());
+		for (int32 i = 0; i < unknownWeapons.Num(); ++i)
+		{
+			GeneratedWeapons[unknownWeapons[i]] = randomWeapons[i];
+		}
+	}
+}
+
+void AWeaponGenerator::onGenerationRequestFinished(int32 RequestId, bool Succeeded, const FWeaponFeatureVector& GeneratedWeapon)
+{
+	FGenerationRequest* request = pendingRequests.FindByPredicate([RequestId](const FGenerationRequest& Request) { return Request.RequestId == RequestId; });
+	if (!request)
+		return;
+
+	request->bIsFinished = true;
+	request->bSucceeded = Succeeded;
+	request->GeneratedWeapon = GeneratedWeapon;
+	finishCompletedRequests();
+}
+
+void AWeaponGenerator::finishCompletedRequests()
+{
+	while (pendingRequests.Num() > 0 && pendingRequests[0].bIsFinished)
+	{
+		const FGenerationRequest request = pendingRequests[0];
+		pendingRequests.RemoveAt(0, 1, false);
+
+		AShooterWeapon* weapon = nullptr;
+		if (request.bSucceeded)
+		{
+			UE_LOG(LogTemp, Verbose, TEXT("Generated weapon (request %i): %s"), request.RequestId, *request.GeneratedWeapon.ToJsonString());
+
+			//only pay for the json data if someone listens
+			if (!request.bUsesPlugin && GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AWeaponGenerator, onDismantledWeaponGeneratedNatively)))
+			{
+				onDismantledWeaponGeneratedNatively(FWeaponGeneratorAPIJsonData::FromFeatureVector(request.DismantledWeapon), FWeaponGeneratorAPIJsonData::FromFeatureVector(request.GeneratedWeapon));
+			}
+			weapon = ConstructWeaponFromFeatures(request.GeneratedWeapon);
+		}
+
+		if (weapon)
+		{
+			OnWeaponGenerationFinishedEvent.Broadcast(weapon);
+		}
+		OnWeaponGenerationRequestFinishedEvent.Broadcast(request.RequestId, weapon);
+	}
+}
+
+void AWeaponGenerator::refillPrefetchPool()
 {
-	bIsGenerating = true;
-	OnStartedWeaponGeneratorEvent.Broadcast();
-	sendDismantledWeaponToGenerator(convertWeaponToJsonData(Weapon));
+	if (bIsRefillingPrefetchPool || prefetchedWeaponsPerType <= 0 || FSessionSeed::IsDeterministic() || !bUseNativeInference || !nativeVAE.IsValid() || isPrefetchPoolFull())
+		return;
+
+	bIsRefillingPrefetchPool = true;
+
+	TSharedPtr<const FWeaponGeneratorVAE, ESPMode::ThreadSafe> vae = nativeVAE;
+	TArray<FWeaponFeatureVector> dismantledWeapons = MoveTemp(dismantledWeaponsToPrefetch);
+	dismantledWeaponsToPrefetch.Reset();
+	const int32 numLatentSamples = prefetchLatentSamplesPerRefill;
+	const int32 numSamples = latentSamplesPerWeapon > 0 ? latentSamplesPerWeapon : vae->GetTrainedBatchSize();
+	const float costThreshold = randomWeaponCostThreshold;
+	const int32 randomSeed = randomNumberGenerator.RandHelper(MAX_int32);
+	const int32 modelGeneration = nativeModelGeneration;
+	TWeakObjectPtr<AWeaponGenerator> weakThis(this);
+
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [vae, dismantledWeapons, numLatentSamples, numSamples, costThreshold, randomSeed, modelGeneration, weakThis]()
+	{
+		FRandomStream randomStream(randomSeed);
+		TArray<FWeaponFeatureVector> generatedWeapons;
+		generatedWeapons.SetNum(dismantledWeapons.Num() + numLatentSamples);
+
+		if (dismantledWeapons.Num() > 0)
+		{
+			generateNatively(*vae, dismantledWeapons.GetData(), generatedWeapons.GetData(), dismantledWeapons.Num(), numSamples, costThreshold, randomStream);
+		}
+
+		//like the random weapons of the TensorFlow plugin
+		if (numLatentSamples > 0)
+		{
+			TArray<float> z;
+			z.SetNumUninitialized(numLatentSamples * vae->GetLatentDimension());
+			vae->SampleLatentSpace(z.GetData(), randomStream, numLatentSamples);
+			vae->DecodeBatch(z.GetData(), generatedWeapons[dismantledWeapons.Num()].Values, numLatentSamples);
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [weakThis, generatedWeapons, modelGeneration]()
+		{
+			if (AWeaponGenerator* generator = weakThis.Get())
+			{
+				generator->onPrefetchRefillFinished(generatedWeapons, modelGeneration);
+			}
+		});
+	});
+}
+
+void AWeaponGenerator::onPrefetchRefillFinished(const TArray<FWeaponFeatureVector>& GeneratedWeapons, int32 ModelGeneration)
+{
+	bIsRefillingPrefetchPool = false;
+
+	//the model was reloaded while the refill was running, so the weapons are from the previous model
+	if (ModelGeneration != nativeModelGeneration)
+	{
+		refillPrefetchPool();
+		return;
+	}
+
+	int32 numAddedWeapons = 0;
+	for (FWeaponFeatureVector generatedWeapon : GeneratedWeapons)
+	{
+		const EWeaponType weaponType = determineWeaponType(generatedWeapon);
+		TArray<FWeaponFeatureVector>& pool = prefetchPool[static_cast<int32>(weaponType)];
+		if (pool.Num() < prefetchedWeaponsPerType)
+		{
+			//fix the type, otherwise constructing the weapon could pick another one
+			generatedWeapon.SetWeaponType(weaponType);
+			pool.Add(generatedWeapon);
+			++numAddedWeapons;
+		}
+	}
+
+	//the VAE rarely generates some types, so don't keep sampling if the refill didn't help at all
+	if (numAddedWeapons > 0 || dismantledWeaponsToPrefetch.Num() > 0)
+	{
+		refillPrefetchPool();
+	}
+}
+
+bool AWeaponGenerator::isPrefetchPoolFull() const
+{
+	for (const TArray<FWeaponFeatureVector>& pool : prefetchPool)
+	{
+		if (pool.Num() < prefetchedWeaponsPerType)
+			return false;
+	}
+	return true;
+}
+
+void AWeaponGenerator::sendNextRequestToPlugin()
+{
+	if (pluginRequestId != INDEX_NONE)
+		return;
+
+	for (const FGenerationRequest& request : pendingRequests)
+	{
+		if (request.bUsesPlugin && !request.bIsFinished)
+		{
+			pluginRequestId = request.RequestId;
+			FWeaponGeneratorAPIJsonData jsonData = FWeaponGeneratorAPIJsonData::FromFeatureVector(request.DismantledWeapon);
+			jsonData.success = "hopefully :P";
+			sendDismantledWeaponToGenerator(jsonData);
+			return;
+		}
+	}
 }
 
 // this is just a stub implementation which is called if there is no implementation in BP
@@ -101,12 +449,11 @@ void AWeaponGenerator::sendDismantledWeaponToGenerator_Implementation(const FWea
 
 void AWeaponGenerator::receiveNewWeaponFromGenerator(const FWeaponGeneratorAPIJsonData& JsonData)
 {
-	AShooterWeapon* weapon = constructWeaponFromJsonData(JsonData);
-	if(weapon)
-	{
-		OnWeaponGenerationFinishedEvent.Broadcast(weapon);
-	}
-	bIsGenerating = false;
+	const int32 requestId = pluginRequestId;
+	pluginRequestId = INDEX_NONE;
+
+	onGenerationRequestFinished(requestId, JsonData.success.Equals("true"), JsonData.ToFeatureVector());
+	sendNextRequestToPlugin();
 }
 
 void AWeaponGenerator::setReadyToUse(bool IsReady)
@@ -115,38 +462,34 @@ void AWeaponGenerator::setReadyToUse(bool IsReady)
 	OnGeneratorIsReadyEvent.Broadcast(IsReady);
 }
 
-FWeaponGeneratorAPIJsonData AWeaponGenerator::convertWeaponToJsonData(AShooterWeapon* Weapon)
+FWeaponFeatureVector AWeaponGenerator::convertWeaponToFeatures(AShooterWeapon* Weapon)
 {
-	FVector2D maxDamageWithDistance = Weapon->GetMaxDamageWithDistance();
-	FVector2D minDamageWithDistance = Weapon->GetMinDamageWithDistance();
-	const EWeaponType weaponType = Weapon->GetType();
-	const EFireMode fireMode = Weapon->GetFireMode();
-	FVector2D recoilIncreasePerShot = Weapon->GetRecoilIncreasePerShot();
-	float recoilDecrease = Weapon->GetRecoilDecrease();
-	float bulletSpreadIncrease = Weapon->GetBulletSpreadIncrease();
-	float bulletSpreadDecrease = Weapon->GetBulletSpreadDecrease();
-	int32 rateOfFire = Weapon->GetRateOfFire();
-	int32 bulletsPerMagazine = Weapon->GetBulletsPerMagazine();
-	float reloadTimeEmptyMagazine = Weapon->GetReloadTimeEmptyMagazine();
-	int32 bulletsInOneShot = Weapon->GetBulletsInOneShot();
-	int32 muzzleVelocity = Weapon->GetMuzzleVelocity();
-
-	applySomeModifications(Weapon, maxDamageWithDistance, minDamageWithDistance, recoilIncreasePerShot, recoilDecrease, bulletSpreadIncrease, bulletSpreadDecrease, rateOfFire,
-		bulletsPerMagazine, reloadTimeEmptyMagazine, bulletsInOneShot, muzzleVelocity);
-
-	return FWeaponGeneratorAPIJsonData(maxDamageWithDistance, minDamageWithDistance, weaponType,
-		fireMode, recoilIncreasePerShot, recoilDecrease, bulletSpreadIncrease, bulletSpreadDecrease, rateOfFire,
-		bulletsPerMagazine, reloadTimeEmptyMagazine, bulletsInOneShot, muzzleVelocity);
-
+	FWeaponFeatureVector features;
+	features[EWeaponFeature::DamagesFirst] = Weapon->GetMaxDamageWithDistance().X;
+	features[EWeaponFeature::DamagesLast] = Weapon->GetMinDamageWithDistance().X;
+	features[EWeaponFeature::DistancesFirst] = Weapon->GetMaxDamageWithDistance().Y / PROJECT_MEASURING_UNIT_FACTOR_TO_M;
+	features[EWeaponFeature::DistancesLast] = Weapon->GetMinDamageWithDistance().Y / PROJECT_MEASURING_UNIT_FACTOR_TO_M;
+	features[EWeaponFeature::HipRecoilRight] = Weapon->GetRecoilIncreasePerShot().X;
+	features[EWeaponFeature::HipRecoilUp] = Weapon->GetRecoilIncreasePerShot().Y;
+	features[EWeaponFeature::HipRecoilDecrease] = Weapon->GetRecoilDecrease();
+	features[EWeaponFeature::HipSpreadIncrease] = Weapon->GetBulletSpreadIncrease();
+	features[EWeaponFeature::HipSpreadDecrease] = Weapon->GetBulletSpreadDecrease();
+	features[EWeaponFeature::RateOfFire] = Weapon->GetRateOfFire();
+	features[EWeaponFeature::MagazineSize] = Weapon->GetBulletsPerMagazine();
+	features[EWeaponFeature::ReloadEmpty] = Weapon->GetReloadTimeEmptyMagazine();
+	features[EWeaponFeature::ShotsPerShell] = Weapon->GetBulletsInOneShot();
+	features[EWeaponFeature::InitialSpeed] = Weapon->GetMuzzleVelocity();
+	features.SetWeaponType(Weapon->GetType());
+	features.SetFireMode(Weapon->GetFireMode());
+
+	applySomeModifications(Weapon->GetWeaponStatistics(), features);
+	return features;
 }
 
-AShooterWeapon* AWeaponGenerator::constructWeaponFromJsonData(const FWeaponGeneratorAPIJsonData& JsonData)
+AShooterWeapon* AWeaponGenerator::ConstructWeaponFromFeatures(const FWeaponFeatureVector& Features)
 {
-	if (!JsonData.success.Equals("true"))
-		return nullptr;
-
 	TSubclassOf<AShooterWeapon> weaponClass;
-	switch(determineWeaponType(JsonData))
+	switch(determineWeaponType(Features))
 	{
 	case EWeaponType::Pistol: weaponClass = pistolClass; break;
 	case EWeaponType::Shotgun: weaponClass = shotgunClass; break;
@@ -159,171 +502,165 @@ AShooterWeapon* AWeaponGenerator::constructWeaponFromJsonData(const FWeaponGener
 	if (!weaponClass.GetDefaultObject())
 		return nullptr;
 
-	FActorSpawnParameters spawnParams;
-	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-	AShooterWeapon* weapon = GetWorld()->SpawnActor<AShooterWeapon>(weaponClass, FVector::ZeroVector, FRotator::ZeroRotator, spawnParams);
+	AShooterWeaponPool* weaponPool = AShooterWeaponPool::Get(GetWorld());
+	if (!weaponPool)
+		return nullptr;
+
+	AShooterWeapon* weapon = weaponPool->AcquireWeapon(weaponClass, FTransform::Identity);
 
 	if (!weapon)
 		return nullptr;
 
-	weapon->SetFireMode(determineWeaponFireMode(JsonData));
+	weapon->SetFireMode(determineWeaponFireMode(Features));
 
 	weapon->SetMaxDamageWithDistance(
 		FVector2D(
-			FCString::Atof(*JsonData.damages_first),
-			FMath::Max(0.f, FCString::Atof(*JsonData.distances_first) * PROJECT_MEASURING_UNIT_FACTOR_TO_M)
+			Features[EWeaponFeature::DamagesFirst],
+			FMath::Max(0.f, Features[EWeaponFeature::DistancesFirst] * PROJECT_MEASURING_UNIT_FACTOR_TO_M)
 		));
 	weapon->SetMinDamageWithDistance(
 		FVector2D(
-			FCString::Atof(*JsonData.damages_last),
-			FCString::Atof(*JsonData.distances_last) * PROJECT_MEASURING_UNIT_FACTOR_TO_M
+			Features[EWeaponFeature::DamagesLast],
+			Features[EWeaponFeature::DistancesLast] * PROJECT_MEASURING_UNIT_FACTOR_TO_M
 		));
 
 	//the clamping should fix the recoil bugs
-	const float recoilIncreaseRight = FMath::Clamp(FCString::Atof(*JsonData.hiprecoilright), 0.f, 20.f);
-	const float recoilIncreaseUp = FMath::Clamp(FCString::Atof(*JsonData.hiprecoilup), 0.f, 20.f);
+	const float recoilIncreaseRight = FMath::Clamp(Features[EWeaponFeature::HipRecoilRight], 0.f, 20.f);
+	const float recoilIncreaseUp = FMath::Clamp(Features[EWeaponFeature::HipRecoilUp], 0.f, 20.f);
 	weapon->SetRecoilIncreasePerShot(
 		FVector2D(
 			recoilIncreaseRight,
 			recoilIncreaseUp
 		));
-	weapon->SetRecoilDecrease(FMath::Clamp(FCString::Atof(*JsonData.hiprecoildec), 0.f, 7.5f));
+	weapon->SetRecoilDecrease(FMath::Clamp(Features[EWeaponFeature::HipRecoilDecrease], 0.f, 7.5f));
 
-	const float bulletSpreadIncrease = FMath::Max(0.f, FCString::Atof(*JsonData.hipstandbasespreadinc));
+	const float bulletSpreadIncrease = FMath::Max(0.f, Features[EWeaponFeature::HipSpreadIncrease]);
 	weapon->SetBulletSpreadIncrease(bulletSpreadIncrease);
-	weapon->SetBulletSpreadDecrease(FMath::Clamp(FCString::Atof(*JsonData.hipstandbasespreaddec), 0.f, bulletSpreadIncrease*10.f));
-	
-	int32 magSize = FCString::Atoi(*JsonData.magsize);
-	magSize *= magSize < 0 ? -1 : 1;
+	weapon->SetBulletSpreadDecrease(FMath::Clamp(Features[EWeaponFeature::HipSpreadDecrease], 0.f, bulletSpreadIncrease*10.f));
+
+	//integer features are truncated like the parsed strings were before
+	const int32 magSize = FMath::Abs(FMath::TruncToInt(Features[EWeaponFeature::MagazineSize]));
 	weapon->SetBulletsPerMagazine(FMath::Max(1, magSize));
-	
-	weapon->SetReloadTimeEmptyMagazine(FMath::Max(0.f, FCString::Atof(*JsonData.reloadempty)));
-	weapon->SetBulletsInOneShot(FMath::Max(1, FCString::Atoi(*JsonData.shotspershell)));
 
-	weapon->SetRateOfFire(FCString::Atoi(*JsonData.rof));
-	weapon->SetMuzzleVelocity(FCString::Atoi(*JsonData.initial_speed));
+	weapon->SetReloadTimeEmptyMagazine(FMath::Max(0.f, Features[EWeaponFeature::ReloadEmpty]));
+	weapon->SetBulletsInOneShot(FMath::Max(1, FMath::TruncToInt(Features[EWeaponFeature::ShotsPerShell])));
+
+	weapon->SetRateOfFire(FMath::Max(1, FMath::TruncToInt(Features[EWeaponFeature::RateOfFire])));
+	weapon->SetMuzzleVelocity(FMath::TruncToInt(Features[EWeaponFeature::InitialSpeed]));
 
 	return weapon;
 }
 
-EWeaponType AWeaponGenerator::determineWeaponType(const FWeaponGeneratorAPIJsonData& JsonData)
+EWeaponType AWeaponGenerator::determineWeaponType(const FWeaponFeatureVector& Features)
 {
 	//determine the type first and then generate the weapon based on a base class
-	float typePistol = FCString::Atof(*JsonData.type_Pistol);
-	float typeSniper = FCString::Atof(*JsonData.type_Sniper);
-	float typeRifle = FCString::Atof(*JsonData.type_Rifle);
-	float typeSmg = FCString::Atof(*JsonData.type_SMG);
-	float typeShotgun = FCString::Atof(*JsonData.type_Shotgun);
-	float typeMg = FCString::Atof(*JsonData.type_MG);
-
-	float winnerFirstRound = FMath::Max3(typePistol, typeSniper, typeRifle);
-	float winnerSecondRound = FMath::Max3(winnerFirstRound, typeSmg, typeShotgun);
-	float winner = FMath::Max(winnerSecondRound, typeMg);
-
-
-	TArray<EWeaponType> winnerTypes;
-	if (FMath::IsNearlyEqual(typePistol, winner, weaponTypeSelectionTolerance))
+	struct FTypeFeature
 	{
-		winnerTypes.Add(EWeaponType::Pistol);
-	}
-	if (FMath::IsNearlyEqual(typeSniper, winner, weaponTypeSelectionTolerance))
+		EWeaponFeature Feature;
+		EWeaponType Type;
+	};
+	static const FTypeFeature typeFeatures[] =
 	{
-		winnerTypes.Add(EWeaponType::SniperRifle);
-	}
-	if(FMath::IsNearlyEqual(typeRifle, winner, weaponTypeSelectionTolerance))
-	{
-		winnerTypes.Add(EWeaponType::Rifle);
-	}
-	if (FMath::IsNearlyEqual(typeSmg, winner, weaponTypeSelectionTolerance))
+		{ EWeaponFeature::TypePistol, EWeaponType::Pistol },
+		{ EWeaponFeature::TypeSniper, EWeaponType::SniperRifle },
+		{ EWeaponFeature::TypeRifle, EWeaponType::Rifle },
+		{ EWeaponFeature::TypeSMG, EWeaponType::SubMachineGun },
+		{ EWeaponFeature::TypeShotgun, EWeaponType::Shotgun },
+		{ EWeaponFeature::TypeMG, EWeaponType::HeavyMachineGun }
+	};
+
+	float winner = -MAX_FLT;
+	for (const FTypeFeature& typeFeature : typeFeatures)
 	{
-		winnerTypes.Add(EWeaponType::SubMachineGun);
+		winner = FMath::Max(winner, Features[typeFeature.Feature]);
 	}
-	if (FMath::IsNearlyEqual(typeShotgun, winner, weaponTypeSelectionTolerance))
-	{
-		winnerTypes.Add(EWeaponType::Shotgun);
-	} 
-	if (FMath::IsNearlyEqual(typeMg, winner, weaponTypeSelectionTolerance))
+
+	TArray<EWeaponType, TFixedAllocator<ARRAY_COUNT(typeFeatures)>> winnerTypes;
+	for (const FTypeFeature& typeFeature : typeFeatures)
 	{
-		winnerTypes.Add(EWeaponType::HeavyMachineGun);
+		if (FMath::IsNearlyEqual(Features[typeFeature.Feature], winner, weaponTypeSelectionTolerance))
+		{
+			winnerTypes.Add(typeFeature.Type);
+		}
 	}
 
 	if(winnerTypes.Num() > 0)
 	{
-		randomNumberGenerator.GenerateNewSeed();
 		return winnerTypes[randomNumberGenerator.RandRange(0, winnerTypes.Num() - 1)];
 	}
 
 	return EWeaponType::Rifle;
 }
 
-EFireMode AWeaponGenerator::determineWeaponFireMode(const FWeaponGeneratorAPIJsonData& JsonData)
+EFireMode AWeaponGenerator::determineWeaponFireMode(const FWeaponFeatureVector& Features)
 {
-	float fireModeAutomatic = FCString::Atof(*JsonData.firemode_Automatic);
-	float fireModeSemi = FCString::Atof(*JsonData.firemode_Semi);
-	float fireModeSingle = FCString::Atof(*JsonData.firemode_Single);
-
-	float winner = FMath::Max3(fireModeAutomatic, fireModeSemi, fireModeSingle);
-
-	TArray<EFireMode> winnerFireModes;
-	if (FMath::IsNearlyEqual(fireModeAutomatic, winner, weaponFireModeSelectionTolerance))
+	struct FFireModeFeature
 	{
-		winnerFireModes.Add(EFireMode::Automatic);
-	}
-	if (FMath::IsNearlyEqual(fireModeSemi, winner, weaponFireModeSelectionTolerance))
+		EWeaponFeature Feature;
+		EFireMode FireMode;
+	};
+	static const FFireModeFeature fireModeFeatures[] =
 	{
-		winnerFireModes.Add(EFireMode::SemiAutomatic);
-	}
-	if (FMath::IsNearlyEqual(fireModeSingle, winner, weaponFireModeSelectionTolerance))
+		{ EWeaponFeature::FireModeAutomatic, EFireMode::Automatic },
+		{ EWeaponFeature::FireModeSemi, EFireMode::SemiAutomatic },
+		{ EWeaponFeature::FireModeSingle, EFireMode::SingleFire }
+	};
+
+	const float winner = FMath::Max3(Features[EWeaponFeature::FireModeAutomatic], Features[EWeaponFeature::FireModeSemi], Features[EWeaponFeature::FireModeSingle]);
+
+	TArray<EFireMode, TFixedAllocator<ARRAY_COUNT(fireModeFeatures)>> winnerFireModes;
+	for (const FFireModeFeature& fireModeFeature : fireModeFeatures)
 	{
-		winnerFireModes.Add(EFireMode::SingleFire);
+		if (FMath::IsNearlyEqual(Features[fireModeFeature.Feature], winner, weaponFireModeSelectionTolerance))
+		{
+			winnerFireModes.Add(fireModeFeature.FireMode);
+		}
 	}
 
 	if (winnerFireModes.Num() > 0)
 	{
-		randomNumberGenerator.GenerateNewSeed();
 		return winnerFireModes[randomNumberGenerator.RandRange(0, winnerFireModes.Num() - 1)];
 	}
 
-	return EFireMode::Automatic;;
+	return EFireMode::Automatic;
 }
 
-void AWeaponGenerator::applySomeModifications(AShooterWeapon* Weapon, FVector2D& MaxDamageWithDistance, FVector2D& MinDamageWithDistance, FVector2D& RecoilIncreasePerShot, float& RecoilDecrease, 
-	float& BulletSpreadIncrease, float& BulletSpreadDecrease, int32& RateOfFire, int32& BulletsPerMagazine, float& ReloadTimeEmptyMagazine, int32& BulletsInOneShot, int32& MuzzleVelocity)
+void AWeaponGenerator::applySomeModifications(const FWeaponStatistics& Statistics, FWeaponFeatureVector& Features)
 {
-	randomNumberGenerator.GenerateNewSeed();
 	FVector2D increaseRandomRange = randomModificationStartRange;
 	FVector2D decreaseRandomRange = randomModificationStartRange;
 
 	//offset the range regarding the stats
-	const FWeaponStatistics statistics = Weapon->GetWeaponStatistics();
-	const float offset = (statistics.Kills * offsetPerKill) + (FMath::FloorToInt(statistics.SecondsUsed/60.f)*offsetPerMinuteUsed);
+	const float offset = (Statistics.Kills * offsetPerKill) + (FMath::FloorToInt(Statistics.SecondsUsed/60.f)*offsetPerMinuteUsed);
 	increaseRandomRange += FVector2D(offset, offset);
 	decreaseRandomRange -= FVector2D(offset, offset);
 
+	auto increase = [this, &increaseRandomRange]() { return randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y); };
+	auto decrease = [this, &decreaseRandomRange]() { return randomNumberGenerator.FRandRange(decreaseRandomRange.X, decreaseRandomRange.Y); };
+
 	//damage
-	MaxDamageWithDistance.X *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
-	MinDamageWithDistance.X *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
+	Features[EWeaponFeature::DamagesFirst] *= increase();
+	Features[EWeaponFeature::DamagesLast] *= increase();
 
 	//distance
-	MaxDamageWithDistance.Y *= randomNumberGenerator.FRandRange(decreaseRandomRange.X, decreaseRandomRange.Y); 
-	MinDamageWithDistance.Y *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
-
-	RecoilIncreasePerShot.X *= randomNumberGenerator.FRandRange(decreaseRandomRange.X, decreaseRandomRange.Y);
-	RecoilIncreasePerShot.Y *= randomNumberGenerator.FRandRange(decreaseRandomRange.X, decreaseRandomRange.Y);
+	Features[EWeaponFeature::DistancesFirst] *= decrease();
+	Features[EWeaponFeature::DistancesLast] *= increase();
 
-	RecoilDecrease *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
+	Features[EWeaponFeature::HipRecoilRight] *= decrease();
+	Features[EWeaponFeature::HipRecoilUp] *= decrease();
 
-	BulletSpreadIncrease *= randomNumberGenerator.FRandRange(decreaseRandomRange.X, decreaseRandomRange.Y);
+	Features[EWeaponFeature::HipRecoilDecrease] *= increase();
 
-	BulletSpreadDecrease *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
+	Features[EWeaponFeature::HipSpreadIncrease] *= decrease();
 
-	RateOfFire *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
+	Features[EWeaponFeature::HipSpreadDecrease] *= increase();
 
-	BulletsPerMagazine *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
+	//these are integers on the weapon
+	Features[EWeaponFeature::RateOfFire] = FMath::TruncToFloat(Features[EWeaponFeature::RateOfFire] * increase());
 
-	ReloadTimeEmptyMagazine *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
+	Features[EWeaponFeature::MagazineSize] = FMath::TruncToFloat(Features[EWeaponFeature::MagazineSize] * increase());
 
-	BulletsInOneShot *= 1;
+	Features[EWeaponFeature::ReloadEmpty] *= increase();
 
-	MuzzleVelocity *= randomNumberGenerator.FRandRange(increaseRandomRange.X, increaseRandomRange.Y);
-}
\ No newline at end of file
+	Features[EWeaponFeature::InitialSpeed] = FMath::TruncToFloat(Features[EWeaponFeature::InitialSpeed] * increase());
+}
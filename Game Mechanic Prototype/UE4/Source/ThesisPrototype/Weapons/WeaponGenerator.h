@@ -4,14 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "WeaponFeatureVector.h"
 #include "WeaponGenerator.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnStartedWeaponGeneratorEvent);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGeneratorIsReadyEvent, bool, IsReady);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWeaponGenerationFinishedEvent, class AShooterWeapon*, GeneratedWeapon);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnWeaponGenerationRequestFinishedEvent, int32, RequestId, class AShooterWeapon*, GeneratedWeapon);
 
 
 class AShooterWeapon;
+class FWeaponGeneratorVAE;
 enum class EWeaponType : uint8;
 enum class EFireMode : uint8;
 struct FWeaponStatistics;
@@ -94,9 +97,10 @@ struct FWeaponGeneratorAPIJsonData
 	FString success;
 
 	FWeaponGeneratorAPIJsonData(){}
-	FWeaponGeneratorAPIJsonData(FVector2D MaxDamageWithDistance, FVector2D MinDamageWithDistance, EWeaponType WeaponType, EFireMode FireMode,
-		FVector2D RecoilIncreasePerShot, float RecoilDecrease, float BulletSpreadIncrease, float BulletSpreadDecrease, int32 RateOfFire, int32 BulletsPerMagazine,
-		float ReloadTimeEmptyMagazine, int32 BulletsInOneShot, int32 MuzzleVelocity);
+
+	//the json data is only used to talk to the TensorFlow plugin, everything else works with the feature vector
+	static FWeaponGeneratorAPIJsonData FromFeatureVector(const FWeaponFeatureVector& Features);
+	FWeaponFeatureVector ToFeatureVector() const;
 };
 
 UCLASS()
@@ -122,6 +126,10 @@ class THESISPROTOTYPE_API AWeaponGenerator : public AActor
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator")
 	TSubclassOf<AShooterWeapon>	shotgunClass;
 
+	//weapons of every weapon class above which are spawned into the weapon pool on begin play
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator", meta = (ClampMin = 0))
+	int32 pooledWeaponsPerClass = 2;
+
 	//distmantled weapon multiplier applied for generating a new weapon
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Dismanteld Random Modification")
 	FVector2D randomModificationStartRange;
@@ -142,11 +150,39 @@ class THESISPROTOTYPE_API AWeaponGenerator : public AActor
 	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Dismanteld Random Modification")
 	float weaponFireModeSelectionTolerance = 0.1f;
 
+	//runs the VAE natively with the exported weights instead of sending the dismantled weapon to the TensorFlow plugin
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Native Inference")
+	bool bUseNativeInference = false;
+
+	//model exported with VariationalAutoencoder.export_weights relative to the content directory, *.wvae files are memory mapped and *.json files are parsed
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Native Inference")
+	FString nativeModelFile = "Scripts/trained_vae/model.wvae";
+
+	//how many latent space samples are decoded and averaged per weapon, 0 uses the trained batch size like the TensorFlow plugin
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Native Inference", meta = (ClampMin = 0))
+	int32 latentSamplesPerWeapon = 0;
+
+	//if the VAE doesn't know the dismantled weapon (generation cost is too high) it generates a random one instead
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Native Inference")
+	float randomWeaponCostThreshold = 50.f;
+
+	//how many generated weapons are kept ready per weapon type so a dismantle doesn't have to wait for the VAE, 0 disables the pool
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Native Inference|Prefetch", meta = (ClampMin = 0))
+	int32 prefetchedWeaponsPerType = 0;
+
+	//how many random points of the latent space are decoded per refill of the pool, next to the recently dismantled weapons
+	UPROPERTY(EditDefaultsOnly, Category = "Weapon Generator|Native Inference|Prefetch", meta = (ClampMin = 0))
+	int32 prefetchLatentSamplesPerRefill = 16;
+
 public:
 	AWeaponGenerator();
 
-	//don't forget to subscribe to OnWeaponGenerationFinishedEvent to get notified when the new weapon is generated
-	void DismantleWeapon(AShooterWeapon* Weapon);
+	//queues the generation of a new weapon and returns the request id or INDEX_NONE if the weapon is null or the generator isn't ready.
+	//don't forget to subscribe to OnWeaponGenerationFinishedEvent to get notified when the new weapon is generated, requests finish in the order they were made
+	int32 DismantleWeapon(AShooterWeapon* Weapon);
+
+	//same as DismantleWeapon but generates all weapons with one batched inference call, e.g., for the weapons dropped at the end of a wave
+	TArray<int32> DismantleWeapons(const TArray<AShooterWeapon*>& Weapons);
 
 	UPROPERTY(BlueprintAssignable, Category = "Weapon Generator|Events")
 	FOnGeneratorIsReadyEvent OnGeneratorIsReadyEvent;
@@ -157,28 +193,90 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Weapon Generator|Events")
 	FOnWeaponGenerationFinishedEvent OnWeaponGenerationFinishedEvent;
 
-	FORCEINLINE bool IsGenerating() const {	return bIsGenerating; }
+	//same as OnWeaponGenerationFinishedEvent but with the request id of DismantleWeapon, the weapon is null if the generation failed
+	UPROPERTY(BlueprintAssignable, Category = "Weapon Generator|Events")
+	FOnWeaponGenerationRequestFinishedEvent OnWeaponGenerationRequestFinishedEvent;
+
+	FORCEINLINE bool IsGenerating() const {	return pendingRequests.Num() > 0; }
+	FORCEINLINE int32 GetNumPendingRequests() const { return pendingRequests.Num(); }
 	FORCEINLINE bool IsReadyToUse() const { return bIsReadyToUse; }
 
+	//the native model is loaded on begin play, so these have to be set before, e.g., with SpawnActorDeferred
+	FORCEINLINE bool UsesNativeInference() const { return bUseNativeInference; }
+	FORCEINLINE void SetUseNativeInference(bool UseNativeInference) { bUseNativeInference = UseNativeInference; }
+	FORCEINLINE const FString& GetNativeModelFile() const { return nativeModelFile; }
+	FORCEINLINE void SetNativeModelFile(const FString& ModelFile) { nativeModelFile = ModelFile; }
+
+	//spawns a weapon of the generated type with the features, e.g., to dismantle a weapon of the training data
+	AShooterWeapon* ConstructWeaponFromFeatures(const FWeaponFeatureVector& Features);
+
 protected:
+	virtual void BeginPlay() override;
+
 	UFUNCTION(BlueprintNativeEvent, Category = "Weapon Generator")
 	void sendDismantledWeaponToGenerator(const FWeaponGeneratorAPIJsonData& JsonData);
 
+	//called if the weapon was generated natively, e.g., to collect the dismantled weapons for retraining
+	UFUNCTION(BlueprintImplementableEvent, Category = "Weapon Generator")
+	void onDismantledWeaponGeneratedNatively(const FWeaponGeneratorAPIJsonData& DismantledWeapon, const FWeaponGeneratorAPIJsonData& GeneratedWeapon);
+
+	//(re)loads the native model, e.g., after the model was retrained and exported. does nothing if the model file didn't change
+	UFUNCTION(BlueprintCallable, Category = "Weapon Generator")
+	bool loadNativeModel();
+	//nativeModelFile or its newest version
+	FString findNativeModelFile(FDateTime& OutTimeStamp) const;
+
 	UFUNCTION(BlueprintCallable, Category = "Weapon Generator")
 	void receiveNewWeaponFromGenerator(const FWeaponGeneratorAPIJsonData& JsonData);
 
 	UFUNCTION(BlueprintCallable, Category = "Weapon Generator")
 	void setReadyToUse(bool IsReady);
 
-	FWeaponGeneratorAPIJsonData convertWeaponToJsonData(AShooterWeapon* Weapon);
-	AShooterWeapon* constructWeaponFromJsonData(const FWeaponGeneratorAPIJsonData& JsonData);
-	EWeaponType determineWeaponType(const FWeaponGeneratorAPIJsonData& JsonData);
-	EFireMode determineWeaponFireMode(const FWeaponGeneratorAPIJsonData& JsonData);
-	void applySomeModifications(AShooterWeapon* Weapon, FVector2D& MaxDamageWithDistance, FVector2D& MinDamageWithDistance, FVector2D& RecoilIncreasePerShot, float& RecoilDecrease,
-		float& BulletSpreadIncrease, float& BulletSpreadDecrease, int32& RateOfFire, int32& BulletsPerMagazine, float& ReloadTimeEmptyMagazine,	int32& BulletsInOneShot, int32& MuzzleVelocity);
+	FWeaponFeatureVector convertWeaponToFeatures(AShooterWeapon* Weapon);
+	void dismantleWeapons(AShooterWeapon* const* Weapons, int32 NumWeapons, int32* OutRequestIds);
+	//runs on a background thread, so it must not touch the generator
+	static void generateNatively(const FWeaponGeneratorVAE& VAE, const FWeaponFeatureVector* DismantledWeapons, FWeaponFeatureVector* GeneratedWeapons, int32 NumWeapons,
+		int32 NumSamples, float RandomWeaponCostThreshold, FRandomStream& RandomStream);
+	void onGenerationRequestFinished(int32 RequestId, bool Succeeded, const FWeaponFeatureVector& GeneratedWeapon);
+	//broadcasts all finished requests at the front of the queue, so the requests finish in the order they were made
+	void finishCompletedRequests();
+	void sendNextRequestToPlugin();
+	void refillPrefetchPool();
+	void onPrefetchRefillFinished(const TArray<FWeaponFeatureVector>& GeneratedWeapons, int32 ModelGeneration);
+	bool isPrefetchPoolFull() const;
+	EWeaponType determineWeaponType(const FWeaponFeatureVector& Features);
+	EFireMode determineWeaponFireMode(const FWeaponFeatureVector& Features);
+	void applySomeModifications(const FWeaponStatistics& Statistics, FWeaponFeatureVector& Features);
 
 private:
+	struct FGenerationRequest
+	{
+		int32 RequestId;
+		bool bUsesPlugin;
+		bool bIsFinished;
+		bool bSucceeded;
+		FWeaponFeatureVector DismantledWeapon;
+		FWeaponFeatureVector GeneratedWeapon;
+	};
+
+	//models are shared with the running background jobs, so loading a new one never pulls the weights from under them
+	TSharedPtr<const FWeaponGeneratorVAE, ESPMode::ThreadSafe> nativeVAE;
+	FString loadedNativeModelFile;
+	FDateTime loadedNativeModelTimeStamp;
+	//incremented with every loaded model, so a refill of the prefetch pool knows if its weapons are outdated
+	int32 nativeModelGeneration = 0;
 	FRandomStream randomNumberGenerator;
-	bool bIsGenerating = false;
+	//in the order the requests were made
+	TArray<FGenerationRequest> pendingRequests;
+	int32 nextRequestId = 0;
+	//the plugin can only handle one request at a time
+	int32 pluginRequestId = INDEX_NONE;
+
+	//one pool per EWeaponType
+	static const int32 NumWeaponTypes = 6;
+	TArray<FWeaponFeatureVector> prefetchPool[NumWeaponTypes];
+	//encoded and decoded with the next refill
+	TArray<FWeaponFeatureVector> dismantledWeaponsToPrefetch;
+	bool bIsRefillingPrefetchPool = false;
 	bool bIsReadyToUse = false;
 };
@@ -0,0 +1,515 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#include "WeaponGeneratorVAE.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+void FWeaponGeneratorVAE::FDenseLayer::Forward(const float* Input, float* Output, int32 NumRows) const
+{
+	for (int32 r = 0; r < NumRows; ++r)
+	{
+		FMemory::Memcpy(Output + r * NumOutputs, Biases, NumOutputs * sizeof(float));
+	}
+
+	//y = x * W + b, every weight row is applied to all rows of the batch while it is in the cache
+	//and the inner loop runs over contiguous memory so the compiler can vectorize it
+	const float* row = Weights;
+	for (int32 i = 0; i < NumInputs; ++i, row += NumOutputs)
+	{
+		for (int32 r = 0; r < NumRows; ++r)
+		{
+			const float input = Input[r * NumInputs + i];
+			float* output = Output + r * NumOutputs;
+			for (int32 o = 0; o < NumOutputs; ++o)
+			{
+				output[o] += input * row[o];
+			}
+		}
+	}
+}
+
+FWeaponGeneratorVAE::FWeaponGeneratorVAE()
+{
+}
+
+FWeaponGeneratorVAE::~FWeaponGeneratorVAE()
+{
+	//unmap the region before the file gets closed
+	mappedRegion.Reset();
+	mappedFile.Reset();
+}
+
+bool FWeaponGeneratorVAE::LoadFromFile(const FString& FilePath)
+{
+	mappedRegion.Reset();
+	mappedFile.Reset();
+	ownedImage.Empty();
+
+	bIsLoaded = FPaths::GetExtension(FilePath) == TEXT("json") ? loadJson(FilePath) : loadBinary(FilePath);
+	if (bIsLoaded)
+	{
+		UE_LOG(LogTemp, Log, TEXT("VAE model '%s' loaded (hidden %i/%i, latent %i)"), *FilePath, encoderHidden1.NumOutputs,
+			bHasSecondHiddenLayer ? encoderHidden2.NumOutputs : 0, numLatent);
+	}
+	return bIsLoaded;
+}
+
+void FWeaponGeneratorVAE::FFileHeader::GetExpectedTensorSizes(int32 OutSizes[NumTensors]) const
+{
+	const int32 numHiddenOut = NumHidden2 > 0 ? NumHidden2 : NumHidden1;
+	OutSizes[Tensor_Mean] = NumInput;
+	OutSizes[Tensor_StandardDeviation] = NumInput;
+	OutSizes[Tensor_EncoderHidden1Weights] = NumInput * NumHidden1;
+	OutSizes[Tensor_EncoderHidden1Biases] = NumHidden1;
+	OutSizes[Tensor_EncoderHidden2Weights] = NumHidden1 * NumHidden2;
+	OutSizes[Tensor_EncoderHidden2Biases] = NumHidden2;
+	OutSizes[Tensor_EncoderZMeanWeights] = numHiddenOut * NumLatent;
+	OutSizes[Tensor_EncoderZMeanBiases] = NumLatent;
+	OutSizes[Tensor_EncoderZLogSigmaSqWeights] = numHiddenOut * NumLatent;
+	OutSizes[Tensor_EncoderZLogSigmaSqBiases] = NumLatent;
+	OutSizes[Tensor_DecoderHidden1Weights] = NumLatent * NumHidden1;
+	OutSizes[Tensor_DecoderHidden1Biases] = NumHidden1;
+	OutSizes[Tensor_DecoderHidden2Weights] = NumHidden1 * NumHidden2;
+	OutSizes[Tensor_DecoderHidden2Biases] = NumHidden2;
+	OutSizes[Tensor_DecoderOutWeights] = numHiddenOut * NumInput;
+	OutSizes[Tensor_DecoderOutBiases] = NumInput;
+}
+
+bool FWeaponGeneratorVAE::loadBinary(const FString& FilePath)
+{
+	mappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	if (mappedFile.IsValid())
+	{
+		mappedRegion.Reset(mappedFile->MapRegion());
+	}
+
+	if (mappedRegion.IsValid())
+	{
+		if (bindImage(mappedRegion->GetMappedPtr(), mappedRegion->GetMappedSize()))
+		{
+			return true;
+		}
+	}
+	else
+	{
+		//not every platform supports memory mapped files, so just read it into memory
+		mappedFile.Reset();
+		if (FFileHelper::LoadFileToArray(ownedImage, *FilePath) && bindImage(ownedImage.GetData(), ownedImage.Num()))
+		{
+			return true;
+		}
+	}
+
+	UE_LOG(LogTemp, Error, TEXT("Couldn't load VAE model file '%s'! Either it doesn't exist or it isn't a valid model file."), *FilePath);
+	return false;
+}
+
+bool FWeaponGeneratorVAE::loadJson(const FString& FilePath)
+{
+	FString jsonString;
+	if (!FFileHelper::LoadFileToString(jsonString, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Couldn't read VAE model file '%s'!"), *FilePath);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> model;
+	TSharedRef<TJsonReader<>> reader = TJsonReaderFactory<>::Create(jsonString);
+	if (!FJsonSerializer::Deserialize(reader, model) || !model.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("VAE model file '%s' is no valid JSON!"), *FilePath);
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* columns = nullptr;
+	const TArray<TSharedPtr<FJsonValue>>* means = nullptr;
+	const TArray<TSharedPtr<FJsonValue>>* standardDeviations = nullptr;
+	const TSharedPtr<FJsonObject>* layers = nullptr;
+	if (model->GetIntegerField("n_input") != NumFeatures || !model->TryGetArrayField("columns", columns) || !model->TryGetArrayField("mean", means)
+		|| !model->TryGetArrayField("std", standardDeviations) || !model->TryGetObjectField("layers", layers)
+		|| columns->Num() != NumFeatures || means->Num() != NumFeatures || standardDeviations->Num() != NumFeatures)
+	{
+		UE_LOG(LogTemp, Error, TEXT("VAE model file '%s' doesn't match the weapon features!"), *FilePath);
+		return false;
+	}
+
+	static const TCHAR* const transferFunctionNames[] = { TEXT("tanh"), TEXT("elu"), TEXT("relu"), TEXT("softplus"), TEXT("sigmoid") };
+	const FString transferFunctionName = model->GetStringField("transfer_fct");
+	uint32 transferFunctionIndex = 0;
+	while (transferFunctionIndex < ARRAY_COUNT(transferFunctionNames) && transferFunctionName != transferFunctionNames[transferFunctionIndex])
+	{
+		++transferFunctionIndex;
+	}
+	if (transferFunctionIndex >= ARRAY_COUNT(transferFunctionNames))
+	{
+		UE_LOG(LogTemp, Error, TEXT("VAE model file '%s' uses the unsupported transfer function '%s'!"), *FilePath, *transferFunctionName);
+		return false;
+	}
+
+	//build the header and the tensor table of the binary format
+	FFileHeader header;
+	FMemory::Memzero(header);
+	header.Magic = FFileHeader::ExpectedMagic;
+	header.Version = FFileHeader::ExpectedVersion;
+	header.TransferFunction = transferFunctionIndex;
+	header.NumInput = NumFeatures;
+	header.NumHidden1 = model->GetIntegerField("n_hidden_1");
+	header.NumHidden2 = FMath::Max(0, model->GetIntegerField("n_hidden_2"));
+	header.NumLatent = model->GetIntegerField("n_z");
+	header.BatchSize = model->GetIntegerField("batch_size");
+
+	int32 tensorSizes[NumTensors];
+	header.GetExpectedTensorSizes(tensorSizes);
+	uint32 imageSize = Align(sizeof(FFileHeader), FFileHeader::TensorAlignment);
+	for (int32 tensor = 0; tensor < NumTensors; ++tensor)
+	{
+		header.Tensors[tensor].Offset = imageSize;
+		header.Tensors[tensor].Num = tensorSizes[tensor];
+		imageSize = Align(imageSize + tensorSizes[tensor] * sizeof(float), FFileHeader::TensorAlignment);
+	}
+
+	ownedImage.SetNumZeroed(imageSize);
+	FMemory::Memcpy(ownedImage.GetData(), &header, sizeof(FFileHeader));
+	auto getTensor = [this, &header](ETensor Tensor) { return reinterpret_cast<float*>(ownedImage.GetData() + header.Tensors[Tensor].Offset); };
+
+	struct FJsonLayer
+	{
+		const TCHAR* Name;
+		ETensor WeightsTensor;
+		TArray<float> Weights;
+		TArray<float> Biases;
+	} jsonLayers[] =
+	{
+		{ TEXT("encoder_h1"), Tensor_EncoderHidden1Weights },
+		{ TEXT("encoder_h2"), Tensor_EncoderHidden2Weights },
+		{ TEXT("encoder_z_mean"), Tensor_EncoderZMeanWeights },
+		{ TEXT("encoder_z_ls2"), Tensor_EncoderZLogSigmaSqWeights },
+		{ TEXT("decoder_h1"), Tensor_DecoderHidden1Weights },
+		{ TEXT("decoder_h2"), Tensor_DecoderHidden2Weights },
+		{ TEXT("decoder_out"), Tensor_DecoderOutWeights }
+	};
+	for (FJsonLayer& layer : jsonLayers)
+	{
+		//an unused second hidden layer has no tensors in the image
+		if (tensorSizes[layer.WeightsTensor + 1] == 0)
+		{
+			continue;
+		}
+		if (!readJsonLayer(**layers, layer.Name, header, layer.WeightsTensor, layer.Weights, layer.Biases))
+		{
+			UE_LOG(LogTemp, Error, TEXT("VAE model file '%s' has a missing or malformed layer '%s'!"), *FilePath, layer.Name);
+			return false;
+		}
+		FMemory::Memcpy(getTensor(layer.WeightsTensor), layer.Weights.GetData(), layer.Weights.Num() * sizeof(float));
+		FMemory::Memcpy(getTensor(static_cast<ETensor>(layer.WeightsTensor + 1)), layer.Biases.GetData(), layer.Biases.Num() * sizeof(float));
+	}
+
+	//the feature columns of TensorFlow are sorted by name, so remap the input and output layer to the order of FWeaponFeatureVector
+	const FJsonLayer& modelEncoderHidden1 = jsonLayers[0];
+	const FJsonLayer& modelDecoderOut = jsonLayers[6];
+	const int32 numHidden1 = header.NumHidden1;
+	const int32 numHiddenOut = header.NumHidden2 > 0 ? header.NumHidden2 : header.NumHidden1;
+	for (int32 column = 0; column < NumFeatures; ++column)
+	{
+		//the engine scripts name the muzzle velocity like the json data of the generator
+		FString columnName = (*columns)[column]->AsString();
+		if (columnName == TEXT("initial_speed"))
+		{
+			columnName = TEXT("initialspeed");
+		}
+		int32 feature = 0;
+		while (feature < NumFeatures && columnName != FWeaponFeatureVector::FeatureNames[feature])
+		{
+			++feature;
+		}
+		if (feature >= NumFeatures)
+		{
+			UE_LOG(LogTemp, Error, TEXT("VAE model file '%s' has the unknown feature column '%s'!"), *FilePath, *columnName);
+			return false;
+		}
+
+		FMemory::Memcpy(getTensor(Tensor_EncoderHidden1Weights) + feature * numHidden1, &modelEncoderHidden1.Weights[column * numHidden1], numHidden1 * sizeof(float));
+		for (int32 i = 0; i < numHiddenOut; ++i)
+		{
+			getTensor(Tensor_DecoderOutWeights)[i * NumFeatures + feature] = modelDecoderOut.Weights[i * NumFeatures + column];
+		}
+		getTensor(Tensor_DecoderOutBiases)[feature] = modelDecoderOut.Biases[column];
+
+		getTensor(Tensor_Mean)[feature] = (*means)[column]->AsNumber();
+		//constant features would divide by zero, just keep their values
+		const float deviation = (*standardDeviations)[column]->AsNumber();
+		getTensor(Tensor_StandardDeviation)[feature] = deviation > 0.f ? deviation : 1.f;
+	}
+
+	return bindImage(ownedImage.GetData(), ownedImage.Num());
+}
+
+bool FWeaponGeneratorVAE::readJsonLayer(const FJsonObject& Layers, const FString& Name, const FFileHeader& Header, ETensor WeightsTensor, TArray<float>& OutWeights, TArray<float>& OutBiases)
+{
+	const TSharedPtr<FJsonObject>* layer = nullptr;
+	const TArray<TSharedPtr<FJsonValue>>* weights = nullptr;
+	const TArray<TSharedPtr<FJsonValue>>* biases = nullptr;
+	if (!Layers.TryGetObjectField(Name, layer) || !(*layer)->TryGetArrayField("weights", weights) || !(*layer)->TryGetArrayField("biases", biases)
+		|| weights->Num() != Header.Tensors[WeightsTensor].Num || biases->Num() != Header.Tensors[WeightsTensor + 1].Num)
+	{
+		return false;
+	}
+
+	OutWeights.SetNumUninitialized(weights->Num());
+	for (int32 i = 0; i < weights->Num(); ++i)
+	{
+		OutWeights[i] = (*weights)[i]->AsNumber();
+	}
+	OutBiases.SetNumUninitialized(biases->Num());
+	for (int32 i = 0; i < biases->Num(); ++i)
+	{
+		OutBiases[i] = (*biases)[i]->AsNumber();
+	}
+	return true;
+}
+
+bool FWeaponGeneratorVAE::bindImage(const uint8* Image, int64 ImageSize)
+{
+	if (ImageSize < static_cast<int64>(sizeof(FFileHeader)))
+	{
+		return false;
+	}
+
+	const FFileHeader& header = *reinterpret_cast<const FFileHeader*>(Image);
+	if (header.Magic != FFileHeader::ExpectedMagic || header.Version != FFileHeader::ExpectedVersion || header.NumInput != NumFeatures
+		|| header.TransferFunction > static_cast<uint32>(EVAETransferFunction::Sigmoid) || header.NumHidden1 <= 0 || header.NumHidden2 < 0 || header.NumLatent <= 0)
+	{
+		return false;
+	}
+
+	int32 expectedSizes[NumTensors];
+	header.GetExpectedTensorSizes(expectedSizes);
+	for (int32 tensor = 0; tensor < NumTensors; ++tensor)
+	{
+		const FFileHeader::FTensorEntry& entry = header.Tensors[tensor];
+		if (entry.Num != static_cast<uint32>(expectedSizes[tensor]) || entry.Offset % sizeof(float) != 0
+			|| static_cast<int64>(entry.Offset) + entry.Num * sizeof(float) > ImageSize)
+		{
+			return false;
+		}
+	}
+
+	transferFunction = static_cast<EVAETransferFunction>(header.TransferFunction);
+	bHasSecondHiddenLayer = header.NumHidden2 > 0;
+	numLatent = header.NumLatent;
+	trainedBatchSize = FMath::Max(1, header.BatchSize);
+
+	const int32 numHiddenOut = bHasSecondHiddenLayer ? header.NumHidden2 : header.NumHidden1;
+	encoderHidden1 = bindLayer(Image, Tensor_EncoderHidden1Weights, NumFeatures, header.NumHidden1);
+	encoderHidden2 = bindLayer(Image, Tensor_EncoderHidden2Weights, header.NumHidden1, header.NumHidden2);
+	encoderZMean = bindLayer(Image, Tensor_EncoderZMeanWeights, numHiddenOut, numLatent);
+	encoderZLogSigmaSq = bindLayer(Image, Tensor_EncoderZLogSigmaSqWeights, numHiddenOut, numLatent);
+	decoderHidden1 = bindLayer(Image, Tensor_DecoderHidden1Weights, numLatent, header.NumHidden1);
+	decoderHidden2 = bindLayer(Image, Tensor_DecoderHidden2Weights, header.NumHidden1, header.NumHidden2);
+	decoderOut = bindLayer(Image, Tensor_DecoderOutWeights, numHiddenOut, NumFeatures);
+
+	mean = reinterpret_cast<const float*>(Image + header.Tensors[Tensor_Mean].Offset);
+	standardDeviation = reinterpret_cast<const float*>(Image + header.Tensors[Tensor_StandardDeviation].Offset);
+	return true;
+}
+
+FWeaponGeneratorVAE::FDenseLayer FWeaponGeneratorVAE::bindLayer(const uint8* Image, ETensor WeightsTensor, int32 NumInputs, int32 NumOutputs) const
+{
+	const FFileHeader& header = *reinterpret_cast<const FFileHeader*>(Image);
+
+	FDenseLayer layer;
+	layer.NumInputs = NumInputs;
+	layer.NumOutputs = NumOutputs;
+	layer.Weights = reinterpret_cast<const float*>(Image + header.Tensors[WeightsTensor].Offset);
+	layer.Biases = reinterpret_cast<const float*>(Image + header.Tensors[WeightsTensor + 1].Offset);
+	return layer;
+}
+
+void FWeaponGeneratorVAE::EncodeAndDecode(const float* Input, float* Output, int32 NumSamples, FRandomStream& RandomStream, float* OutLoss) const
+{
+	EncodeAndDecodeBatch(Input, Output, 1, NumSamples, RandomStream, OutLoss);
+}
+
+void FWeaponGeneratorVAE::EncodeAndDecodeBatch(const float* Inputs, float* Outputs, int32 NumWeapons, int32 NumSamples, FRandomStream& RandomStream, float* OutLosses) const
+{
+	check(bIsLoaded);
+
+	FScratchBuffer standardized;
+	standardized.SetNumUninitialized(NumWeapons * NumFeatures);
+	for (int32 i = 0; i < standardized.Num(); ++i)
+	{
+		const int32 feature = i % NumFeatures;
+		standardized[i] = (Inputs[i] - mean[feature]) / standardDeviation[feature];
+	}
+
+	FScratchBuffer hidden;
+	forwardHiddenLayers(encoderHidden1, encoderHidden2, standardized.GetData(), NumWeapons, hidden);
+
+	FScratchBuffer zMean;
+	FScratchBuffer zLogSigmaSq;
+	zMean.SetNumUninitialized(NumWeapons * numLatent);
+	zLogSigmaSq.SetNumUninitialized(NumWeapons * numLatent);
+	encoderZMean.Forward(hidden.GetData(), zMean.GetData(), NumWeapons);
+	encoderZLogSigmaSq.Forward(hidden.GetData(), zLogSigmaSq.GetData(), NumWeapons);
+
+	//z = mu + sigma*epsilon, all samples of all weapons are decoded together
+	const int32 numSamples = FMath::Max(1, NumSamples);
+	FScratchBuffer z;
+	z.SetNumUninitialized(NumWeapons * numSamples * numLatent);
+	for (int32 weapon = 0; weapon < NumWeapons; ++weapon)
+	{
+		const float* weaponZMean = zMean.GetData() + weapon * numLatent;
+		const float* weaponZLogSigmaSq = zLogSigmaSq.GetData() + weapon * numLatent;
+		for (int32 sample = 0; sample < numSamples; ++sample)
+		{
+			float* sampleZ = z.GetData() + (weapon * numSamples + sample) * numLatent;
+			for (int32 i = 0; i < numLatent; ++i)
+			{
+				sampleZ[i] = weaponZMean[i] + FMath::Exp(0.5f * weaponZLogSigmaSq[i]) * sampleGaussian(RandomStream);
+			}
+		}
+	}
+
+	FScratchBuffer reconstructions;
+	reconstructions.SetNumUninitialized(NumWeapons * numSamples * NumFeatures);
+	decodeStandardized(z.GetData(), reconstructions.GetData(), NumWeapons * numSamples);
+
+	for (int32 weapon = 0; weapon < NumWeapons; ++weapon)
+	{
+		const float* weaponStandardized = standardized.GetData() + weapon * NumFeatures;
+		float reconstructionSum[NumFeatures] = {};
+		float reconstructionLoss = 0.f;
+		for (int32 sample = 0; sample < numSamples; ++sample)
+		{
+			const float* reconstruction = reconstructions.GetData() + (weapon * numSamples + sample) * NumFeatures;
+			for (int32 i = 0; i < NumFeatures; ++i)
+			{
+				const float difference = reconstruction[i] - weaponStandardized[i];
+				reconstructionLoss += difference * difference;
+				reconstructionSum[i] += reconstruction[i];
+			}
+		}
+
+		float* output = Outputs + weapon * NumFeatures;
+		for (int32 i = 0; i < NumFeatures; ++i)
+		{
+			output[i] = mean[i] + (reconstructionSum[i] / numSamples) * standardDeviation[i];
+		}
+
+		if (OutLosses)
+		{
+			//kullback leibler divergence, it doesn't depend on the sampled z
+			const float* weaponZMean = zMean.GetData() + weapon * numLatent;
+			const float* weaponZLogSigmaSq = zLogSigmaSq.GetData() + weapon * numLatent;
+			float latentLoss = 0.f;
+			for (int32 i = 0; i < numLatent; ++i)
+			{
+				latentLoss += 1.f + weaponZLogSigmaSq[i] - weaponZMean[i] * weaponZMean[i] - FMath::Exp(weaponZLogSigmaSq[i]);
+			}
+			latentLoss *= -0.5f;
+
+			OutLosses[weapon] = reconstructionLoss / numSamples + latentLoss;
+		}
+	}
+}
+
+void FWeaponGeneratorVAE::DecodeFromLatentSpace(const float* Z, float* Output) const
+{
+	DecodeBatch(Z, Output, 1);
+}
+
+void FWeaponGeneratorVAE::DecodeBatch(const float* Z, float* Outputs, int32 NumWeapons) const
+{
+	check(bIsLoaded);
+
+	decodeStandardized(Z, Outputs, NumWeapons);
+	for (int32 i = 0; i < NumWeapons * NumFeatures; ++i)
+	{
+		const int32 feature = i % NumFeatures;
+		Outputs[i] = mean[feature] + Outputs[i] * standardDeviation[feature];
+	}
+}
+
+void FWeaponGeneratorVAE::SampleLatentSpace(float* OutZ, FRandomStream& RandomStream, int32 NumPoints) const
+{
+	for (int32 i = 0; i < NumPoints * numLatent; ++i)
+	{
+		OutZ[i] = sampleGaussian(RandomStream);
+	}
+}
+
+void FWeaponGeneratorVAE::applyTransferFunction(float* Values, int32 Num) const
+{
+	switch (transferFunction)
+	{
+	case EVAETransferFunction::Tanh:
+		for (int32 i = 0; i < Num; ++i)
+		{
+			Values[i] = 1.f - 2.f / (FMath::Exp(2.f * Values[i]) + 1.f);
+		}
+		break;
+	case EVAETransferFunction::Elu:
+		for (int32 i = 0; i < Num; ++i)
+		{
+			Values[i] = Values[i] > 0.f ? Values[i] : FMath::Exp(Values[i]) - 1.f;
+		}
+		break;
+	case EVAETransferFunction::Relu:
+		for (int32 i = 0; i < Num; ++i)
+		{
+			Values[i] = FMath::Max(Values[i], 0.f);
+		}
+		break;
+	case EVAETransferFunction::Softplus:
+		for (int32 i = 0; i < Num; ++i)
+		{
+			//avoid the overflow of exp, softplus is linear there anyway
+			Values[i] = Values[i] > 20.f ? Values[i] : FMath::Loge(1.f + FMath::Exp(Values[i]));
+		}
+		break;
+	case EVAETransferFunction::Sigmoid:
+		for (int32 i = 0; i < Num; ++i)
+		{
+			Values[i] = 1.f / (1.f + FMath::Exp(-Values[i]));
+		}
+		break;
+	}
+}
+
+void FWeaponGeneratorVAE::forwardHiddenLayers(const FDenseLayer& Hidden1, const FDenseLayer& Hidden2, const float* Input, int32 NumRows, FScratchBuffer& Output) const
+{
+	FScratchBuffer hidden1;
+	hidden1.SetNumUninitialized(NumRows * Hidden1.NumOutputs);
+	Hidden1.Forward(Input, hidden1.GetData(), NumRows);
+	applyTransferFunction(hidden1.GetData(), hidden1.Num());
+
+	if (!bHasSecondHiddenLayer)
+	{
+		Output = MoveTemp(hidden1);
+		return;
+	}
+
+	Output.SetNumUninitialized(NumRows * Hidden2.NumOutputs);
+	Hidden2.Forward(hidden1.GetData(), Output.GetData(), NumRows);
+	applyTransferFunction(Output.GetData(), Output.Num());
+}
+
+void FWeaponGeneratorVAE::decodeStandardized(const float* Z, float* Output, int32 NumRows) const
+{
+	FScratchBuffer hidden;
+	forwardHiddenLayers(decoderHidden1, decoderHidden2, Z, NumRows, hidden);
+	decoderOut.Forward(hidden.GetData(), Output, NumRows);
+}
+
+float FWeaponGeneratorVAE::sampleGaussian(FRandomStream& RandomStream) const
+{
+	//box muller transform, FRand is in [0,1) so flip it to avoid log(0)
+	const float uniform1 = 1.f - RandomStream.FRand();
+	const float uniform2 = RandomStream.FRand();
+	return FMath::Sqrt(-2.f * FMath::Loge(uniform1)) * FMath::Cos(2.f * PI * uniform2);
+}
@@ -0,0 +1,162 @@
+// Copyright 2018 - Bernhard Rieder - All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponFeatureVector.h"
+
+class FJsonObject;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+//activation functions of the hidden layers, named like the TensorFlow functions
+enum class EVAETransferFunction : uint8
+{
+	Tanh,
+	Elu,
+	Relu,
+	Softplus,
+	Sigmoid
+};
+
+/**
+ * Native inference of the variational autoencoder trained in "TensorFlow Playground/variational_autoencoder.py".
+ * Loads the weights exported with VariationalAutoencoder.export_weights and runs the encoder and decoder
+ * with plain float matrix kernels, so the game doesn't need a TensorFlow session to generate weapons.
+ * All inputs and outputs are unstandardized features in the order of FWeaponFeatureVector.
+ */
+class THESISPROTOTYPE_API FWeaponGeneratorVAE
+{
+public:
+	//14 numerical features + 6 weapon types + 3 fire modes
+	static const int32 NumFeatures = FWeaponFeatureVector::NumFeatures;
+
+	FWeaponGeneratorVAE();
+	~FWeaponGeneratorVAE();
+
+	//loads a model exported with VariationalAutoencoder.export_weights, binary models (*.wvae) are memory mapped without any copy
+	bool LoadFromFile(const FString& FilePath);
+
+	FORCEINLINE bool IsLoaded() const { return bIsLoaded; }
+	FORCEINLINE int32 GetLatentDimension() const { return numLatent; }
+	FORCEINLINE int32 GetTrainedBatchSize() const { return trainedBatchSize; }
+
+	//same as VariationalAutoencoder.encode_and_decode(x, False): decodes NumSamples samples of the latent space and returns their mean.
+	//OutLoss (optional) receives the average cost of the samples like VariationalAutoencoder.calculate_loss
+	void EncodeAndDecode(const float* Input, float* Output, int32 NumSamples, FRandomStream& RandomStream, float* OutLoss = nullptr) const;
+
+	//EncodeAndDecode for NumWeapons inputs in one pass, Inputs and Outputs are NumWeapons rows of NumFeatures and OutLosses (optional) has one entry per weapon
+	void EncodeAndDecodeBatch(const float* Inputs, float* Outputs, int32 NumWeapons, int32 NumSamples, FRandomStream& RandomStream, float* OutLosses = nullptr) const;
+
+	//same as VariationalAutoencoder.decode_from_latent_space(z, False)
+	void DecodeFromLatentSpace(const float* Z, float* Output) const;
+
+	//decodes NumWeapons rows of latent space dimension in one pass
+	void DecodeBatch(const float* Z, float* Outputs, int32 NumWeapons) const;
+
+	//samples NumPoints random points of the latent space from a gaussian normal distribution
+	void SampleLatentSpace(float* OutZ, FRandomStream& RandomStream, int32 NumPoints = 1) const;
+
+protected:
+	//tensors of the binary model file in the order of its tensor table, every tensor starts 64 byte aligned
+	enum ETensor
+	{
+		Tensor_Mean,
+		Tensor_StandardDeviation,
+		Tensor_EncoderHidden1Weights,
+		Tensor_EncoderHidden1Biases,
+		Tensor_EncoderHidden2Weights,
+		Tensor_EncoderHidden2Biases,
+		Tensor_EncoderZMeanWeights,
+		Tensor_EncoderZMeanBiases,
+		Tensor_EncoderZLogSigmaSqWeights,
+		Tensor_EncoderZLogSigmaSqBiases,
+		Tensor_DecoderHidden1Weights,
+		Tensor_DecoderHidden1Biases,
+		Tensor_DecoderHidden2Weights,
+		Tensor_DecoderHidden2Biases,
+		Tensor_DecoderOutWeights,
+		Tensor_DecoderOutBiases,
+		NumTensors
+	};
+
+	//little endian file header, see MODEL_FILE_HEADER_FORMAT in variational_autoencoder.py
+	struct FFileHeader
+	{
+		static const uint32 ExpectedMagic = 0x45415657; //'WVAE'
+		static const uint32 ExpectedVersion = 1;
+		static const uint32 TensorAlignment = 64;
+
+		uint32 Magic;
+		uint32 Version;
+		uint32 TransferFunction;
+		int32 NumInput;
+		int32 NumHidden1;
+		//0 if the network has only one hidden layer
+		int32 NumHidden2;
+		int32 NumLatent;
+		int32 BatchSize;
+
+		struct FTensorEntry
+		{
+			//in bytes from the beginning of the file
+			uint32 Offset;
+			//number of floats
+			uint32 Num;
+		} Tensors[NumTensors];
+
+		void GetExpectedTensorSizes(int32 OutSizes[NumTensors]) const;
+	};
+
+	struct FDenseLayer
+	{
+		int32 NumInputs = 0;
+		int32 NumOutputs = 0;
+		//row-major [NumInputs, NumOutputs]
+		const float* Weights = nullptr;
+		const float* Biases = nullptr;
+
+		//Input and Output are NumRows rows of NumInputs and NumOutputs
+		void Forward(const float* Input, float* Output, int32 NumRows = 1) const;
+	};
+
+	//big enough for a single weapon, batches go to the heap
+	typedef TArray<float, TInlineAllocator<256>> FScratchBuffer;
+
+	bool loadBinary(const FString& FilePath);
+	//converts the JSON export into the same image as the binary file
+	bool loadJson(const FString& FilePath);
+	static bool readJsonLayer(const FJsonObject& Layers, const FString& Name, const FFileHeader& Header, ETensor WeightsTensor, TArray<float>& OutWeights, TArray<float>& OutBiases);
+	//points all layers into the model image, the image has to stay valid as long as the model is used
+	bool bindImage(const uint8* Image, int64 ImageSize);
+	FDenseLayer bindLayer(const uint8* Image, ETensor WeightsTensor, int32 NumInputs, int32 NumOutputs) const;
+
+	void applyTransferFunction(float* Values, int32 Num) const;
+	//runs the hidden layers of the encoder or the decoder and returns the output of the last one
+	void forwardHiddenLayers(const FDenseLayer& Hidden1, const FDenseLayer& Hidden2, const float* Input, int32 NumRows, FScratchBuffer& Output) const;
+	void decodeStandardized(const float* Z, float* Output, int32 NumRows) const;
+	float sampleGaussian(FRandomStream& RandomStream) const;
+
+protected:
+	bool bIsLoaded = false;
+	bool bHasSecondHiddenLayer = false;
+	EVAETransferFunction transferFunction = EVAETransferFunction::Tanh;
+	int32 numLatent = 0;
+	int32 trainedBatchSize = 1;
+
+	FDenseLayer encoderHidden1;
+	FDenseLayer encoderHidden2;
+	FDenseLayer encoderZMean;
+	FDenseLayer encoderZLogSigmaSq;
+	FDenseLayer decoderHidden1;
+	FDenseLayer decoderHidden2;
+	FDenseLayer decoderOut;
+
+	const float* mean = nullptr;
+	const float* standardDeviation = nullptr;
+
+	//backing memory of the model image, either the mapped file or a copy in memory
+	TUniquePtr<IMappedFileHandle> mappedFile;
+	TUniquePtr<IMappedFileRegion> mappedRegion;
+	TArray<uint8> ownedImage;
+};